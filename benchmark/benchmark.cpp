@@ -1,4 +1,6 @@
 #include "../include/parser/TrpJsonParser.hpp"
+#include "../include/parser/TrpJsonCborWriter.hpp"
+#include "../include/values/TrpJsonCbor.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -58,6 +60,12 @@ private:
         double serializeTime;
         size_t memoryUsed;
         bool success;
+        // the same document as CBOR, everything in memory with one reused parser
+        size_t cborSize;
+        double textParseTime;
+        double cborEncodeTime;
+        double cborDecodeTime;
+        double cborReadTime;
     };
 
     std::vector<BenchmarkResult> results;
@@ -127,6 +135,7 @@ public:
         result.serializeTime = avgSerializeTime / 1000.0;
         result.memoryUsed = 0; // Will be filled by memory profiling
         result.success = true;
+        runCborBenchmark(filename, result, iterations);
         
         results.push_back(result);
         
@@ -137,6 +146,67 @@ public:
                   << result.serializeTime << " ms" << std::endl;
         std::cout << "Throughput: " << std::fixed << std::setprecision(2) 
                   << (fileSize / 1024.0 / 1024.0) / (result.parseTime / 1000.0) << " MB/s" << std::endl;
+        if (result.cborSize) {
+            std::cout << "CBOR size: " << result.cborSize << " bytes, encode "
+                      << std::setprecision(3) << result.cborEncodeTime << " ms" << std::endl;
+            std::cout << "Text parse (in memory): " << result.textParseTime << " ms, CBOR decode: "
+                      << result.cborDecodeTime << " ms (" << std::setprecision(1)
+                      << result.textParseTime / result.cborDecodeTime << "x), CBOR read: "
+                      << std::setprecision(3) << result.cborReadTime << " ms" << std::endl;
+        }
+    }
+
+    // text parse against CBOR decode on the same bytes in memory, so the file read and the
+    // parser setup are out of both. the parser is reused like a server would
+    void runCborBenchmark(const std::string& filename, BenchmarkResult& result, int iterations) {
+        result.cborSize = 0;
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        std::string text = contents.str();
+
+        TrpJsonParser parser;
+        if (!parser.parse(text.data(), text.size()))
+            return;
+        TrpJsonCborWriter writer;
+        writer.write(parser.getAST());
+        std::string cbor(writer.data(), writer.size());
+
+        double textTime = 0.0, encodeTime = 0.0, decodeTime = 0.0, readTime = 0.0;
+        TrpJsonCbor document;
+        for (int i = 0; i < iterations; ++i) {
+            Timer timer;
+            timer.start();
+            parser.parse(text.data(), text.size());
+            timer.stop();
+            textTime += timer.elapsed();
+
+            timer.start();
+            writer.clear();
+            writer.write(parser.getAST());
+            timer.stop();
+            encodeTime += timer.elapsed();
+
+            timer.start();
+            bool decoded = parser.parseCbor(cbor.data(), cbor.size());
+            timer.stop();
+            decodeTime += timer.elapsed();
+
+            timer.start();
+            bool read = document.read(cbor.data(), cbor.size());
+            timer.stop();
+            readTime += timer.elapsed();
+
+            if (!decoded || !read) {
+                std::cerr << "CBOR decode failed: " << parser.getError().message() << std::endl;
+                return;
+            }
+        }
+        result.cborSize = cbor.size();
+        result.textParseTime = textTime / iterations / 1000.0;
+        result.cborEncodeTime = encodeTime / iterations / 1000.0;
+        result.cborDecodeTime = decodeTime / iterations / 1000.0;
+        result.cborReadTime = readTime / iterations / 1000.0;
     }
     
     void generateReport() {
@@ -165,6 +235,28 @@ public:
         }
         
         std::cout << std::string(80, '=') << std::endl;
+
+        std::cout << "\nCBOR AGAINST TEXT (in memory)" << std::endl;
+        std::cout << std::string(80, '-') << std::endl;
+        std::cout << std::left
+                  << std::setw(25) << "Test Name"
+                  << std::setw(12) << "CBOR Size"
+                  << std::setw(15) << "Text Parse"
+                  << std::setw(15) << "CBOR Decode"
+                  << std::setw(13) << "Speedup"
+                  << std::endl;
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchmarkResult& result = results[i];
+            if (!result.cborSize) continue;
+            std::cout << std::left
+                      << std::setw(25) << result.testName
+                      << std::setw(12) << formatSize(result.cborSize)
+                      << std::setw(15) << (toString(result.textParseTime, 3) + " ms")
+                      << std::setw(15) << (toString(result.cborDecodeTime, 3) + " ms")
+                      << std::setw(13) << (toString(result.textParseTime / result.cborDecodeTime, 1) + "x")
+                      << std::endl;
+        }
+        std::cout << std::string(80, '=') << std::endl;
     }
     
     void generateWebsiteData() {
@@ -0,0 +1,170 @@
+#include "../include/parser/TrpJsonParser.hpp"
+#include "../include/parser/TrpJsonWriter.hpp"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <sys/time.h>
+
+// Serialization only: every file is parsed once, then the same AST is written over and over
+// through astToString(), the compact writer and the indented writer
+
+class Timer {
+private:
+    struct timeval start_time;
+    struct timeval end_time;
+
+public:
+    void start() {
+        gettimeofday(&start_time, NULL);
+    }
+
+    void stop() {
+        gettimeofday(&end_time, NULL);
+    }
+
+    // Returns elapsed time in microseconds
+    double elapsed() const {
+        return (end_time.tv_sec - start_time.tv_sec) * 1000000.0 +
+               (end_time.tv_usec - start_time.tv_usec);
+    }
+};
+
+class WriterBenchmark {
+private:
+    struct WriterResult {
+        std::string testName;
+        size_t outputSize;
+        double astToStringTime;
+        double compactTime;
+        double indentedTime;
+    };
+
+    std::vector<WriterResult> results;
+
+    static double throughput(size_t bytes, double ms) {
+        return ms > 0 ? (bytes / 1024.0 / 1024.0) / (ms / 1000.0) : 0.0;
+    }
+
+public:
+    void runBenchmark(const std::string& filename, const std::string& testName, int iterations) {
+        std::cout << "\n=== Writer benchmark: " << testName << " ===" << std::endl;
+
+        TrpJsonParser parser(filename);
+        if (!parser.parse()) {
+            std::cerr << "Error: cannot parse " << filename << std::endl;
+            return;
+        }
+        ITrpJsonValue* ast = parser.getAST();
+
+        WriterResult result;
+        result.testName = testName;
+
+        Timer timer;
+        size_t sink = 0;
+        timer.start();
+        for (int i = 0; i < iterations; ++i)
+            sink += parser.astToString().size();
+        timer.stop();
+        result.astToStringTime = timer.elapsed() / 1000.0 / iterations;
+
+        // one writer for every iteration, the buffer keeps its memory
+        TrpJsonWriter compact;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            compact.clear();
+            compact.write(ast);
+        }
+        timer.stop();
+        result.compactTime = timer.elapsed() / 1000.0 / iterations;
+        result.outputSize = compact.size();
+
+        TrpJsonWriter indented;
+        indented.setIndent(2);
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            indented.clear();
+            indented.write(ast);
+        }
+        timer.stop();
+        result.indentedTime = timer.elapsed() / 1000.0 / iterations;
+        sink += indented.size();
+
+        results.push_back(result);
+        std::cout << "Compact output: " << result.outputSize << " bytes" << std::endl;
+        std::cout << "astToString: " << std::fixed << std::setprecision(4) << result.astToStringTime << " ms" << std::endl;
+        std::cout << "Compact writer: " << result.compactTime << " ms ("
+                  << std::setprecision(2) << throughput(result.outputSize, result.compactTime) << " MB/s)" << std::endl;
+        std::cout << "Indented writer: " << std::setprecision(4) << result.indentedTime << " ms" << std::endl;
+        if (!sink)
+            std::cout << "(nothing written)" << std::endl;
+    }
+
+    void generateReport() {
+        std::cout << "\n" << std::string(80, '=') << std::endl;
+        std::cout << "WRITER RESULTS SUMMARY" << std::endl;
+        std::cout << std::string(80, '=') << std::endl;
+
+        std::cout << std::left
+                  << std::setw(25) << "Test Name"
+                  << std::setw(15) << "astToString"
+                  << std::setw(15) << "Compact"
+                  << std::setw(15) << "Indented"
+                  << std::setw(10) << "Speedup"
+                  << std::endl;
+        std::cout << std::string(80, '-') << std::endl;
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const WriterResult& result = results[i];
+            std::ostringstream speedup;
+            speedup << std::fixed << std::setprecision(1)
+                    << (result.compactTime > 0 ? result.astToStringTime / result.compactTime : 0.0) << "x";
+            std::ostringstream a, c, d;
+            a << std::fixed << std::setprecision(4) << result.astToStringTime << " ms";
+            c << std::fixed << std::setprecision(4) << result.compactTime << " ms";
+            d << std::fixed << std::setprecision(4) << result.indentedTime << " ms";
+            std::cout << std::left
+                      << std::setw(25) << result.testName
+                      << std::setw(15) << a.str()
+                      << std::setw(15) << c.str()
+                      << std::setw(15) << d.str()
+                      << std::setw(10) << speedup.str()
+                      << std::endl;
+        }
+
+        std::cout << std::string(80, '=') << std::endl;
+    }
+};
+
+int main(int ac, char** av) {
+    std::cout << "TrpJSON Writer Benchmark" << std::endl;
+
+    WriterBenchmark benchmark;
+
+    std::vector<std::pair<std::string, std::string> > testFiles;
+    if (ac > 1) {
+        // any other documents given on the command line
+        for (int i = 1; i < ac; ++i)
+            testFiles.push_back(std::make_pair(std::string(av[i]), std::string(av[i])));
+    } else {
+        testFiles.push_back(std::make_pair("benchmark/data/simple_config.json", "Simple Config"));
+        testFiles.push_back(std::make_pair("benchmark/data/api_response.json", "API Response"));
+        testFiles.push_back(std::make_pair("benchmark/data/large_dataset.json", "Large Dataset"));
+        testFiles.push_back(std::make_pair("benchmark/data/nested_complex.json", "Complex Nested"));
+    }
+
+    for (size_t i = 0; i < testFiles.size(); ++i) {
+        FILE* probe = std::fopen(testFiles[i].first.c_str(), "r");
+        if (!probe) {
+            std::cout << "Skipping " << testFiles[i].second << " - file not found: " << testFiles[i].first << std::endl;
+            continue;
+        }
+        std::fclose(probe);
+        benchmark.runBenchmark(testFiles[i].first, testFiles[i].second, ac > 1 ? 20 : 1000);
+    }
+
+    benchmark.generateReport();
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#ifndef TRPJSONARENA_HPP
+#define TRPJSONARENA_HPP
+
+#define TRP_ARENA_ALIGNMENT 8
+#define TRP_ARENA_CHUNK_SIZE (64 * 1024)
+
+// bump allocator for a whole document. nothing is freed one by one, reset() drops
+// everything at once and keeps every chunk around for the next document: the biggest
+// one first, the others are taken again before anything new is allocated
+class TrpJsonArena {
+    private:
+        struct Chunk {
+            Chunk* next;
+            size_t size;
+        };
+
+        Chunk* m_chunks;
+        // chunks from before the last reset, not in use yet
+        Chunk* m_spare;
+        char* m_cursor;
+        char* m_limit;
+        size_t m_used;
+
+        void* allocateSlow( size_t size );
+        void freeChunks( Chunk* chunk );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonArena( const TrpJsonArena& other );
+        TrpJsonArena& operator=( const TrpJsonArena& other );
+
+    public:
+        TrpJsonArena( void );
+        ~TrpJsonArena( void );
+
+        void* allocate( size_t size ) {
+            size = (size + TRP_ARENA_ALIGNMENT - 1) & ~static_cast<size_t>(TRP_ARENA_ALIGNMENT - 1);
+            if (static_cast<size_t>(m_limit - m_cursor) < size)
+                return allocateSlow(size);
+            void* p = m_cursor;
+            m_cursor += size;
+            m_used += size;
+            return p;
+        }
+
+        // forget every allocation, the memory stays for reuse
+        void reset( void );
+        // give all the memory back, spare chunks too
+        void release( void );
+
+        size_t bytesUsed( void ) const;
+        size_t bytesReserved( void ) const;
+};
+
+// lets the std containers inside the values live in the arena too.
+// no arena means plain operator new, that is the heap mode
+template <typename T>
+class TrpJsonArenaAllocator {
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind {
+            typedef TrpJsonArenaAllocator<U> other;
+        };
+
+        TrpJsonArena* arena;
+
+        TrpJsonArenaAllocator( TrpJsonArena* _arena = NULL ) throw() : arena(_arena) {}
+        TrpJsonArenaAllocator( const TrpJsonArenaAllocator& other ) throw() : arena(other.arena) {}
+        template <typename U>
+        TrpJsonArenaAllocator( const TrpJsonArenaAllocator<U>& other ) throw() : arena(other.arena) {}
+        ~TrpJsonArenaAllocator( void ) throw() {}
+
+        pointer address( reference x ) const { return &x; }
+        const_pointer address( const_reference x ) const { return &x; }
+
+        pointer allocate( size_type n, const void* = 0 ) {
+            if (arena)
+                return static_cast<pointer>(arena->allocate(n * sizeof(T)));
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate( pointer p, size_type ) {
+            if (!arena)
+                ::operator delete(p);
+        }
+
+        size_type max_size( void ) const throw() { return static_cast<size_type>(-1) / sizeof(T); }
+
+        void construct( pointer p, const T& value ) { new (static_cast<void*>(p)) T(value); }
+        void destroy( pointer p ) { p->~T(); }
+};
+
+template <typename T, typename U>
+inline bool operator==( const TrpJsonArenaAllocator<T>& a, const TrpJsonArenaAllocator<U>& b ) {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+inline bool operator!=( const TrpJsonArenaAllocator<T>& a, const TrpJsonArenaAllocator<U>& b ) {
+    return a.arena != b.arena;
+}
+
+#endif // TRPJSONARENA_HPP
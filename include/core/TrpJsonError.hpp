@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifndef TRPJSONERROR_HPP
+#define TRPJSONERROR_HPP
+
+// bytes of offending text an error keeps (a bad literal, a path error...), longer gets cut
+#define TRP_ERROR_DETAIL_BYTES 64
+
+// a bit per token type for TrpJsonError::expected, TRP_EXPECT(T_COMMA) | TRP_EXPECT(T_BRACE_CLOSE)
+#define TRP_EXPECT(type) (1u << (type))
+#define TRP_EXPECT_VALUE (TRP_EXPECT(T_BRACE_OPEN) | TRP_EXPECT(T_BRACKET_OPEN) | TRP_EXPECT(T_STRING) \
+    | TRP_EXPECT(T_NUMBER) | TRP_EXPECT(T_TRUE) | TRP_EXPECT(T_FALSE) | TRP_EXPECT(T_NULL))
+
+enum TrpErrorCode
+{
+    ERROR_NONE,
+    // no input at all
+    ERROR_NO_INPUT,
+    ERROR_OPEN_FAILED,
+    ERROR_READ_FAILED,
+    // grammar, the token is fine but not there
+    ERROR_UNEXPECTED_TOKEN,
+    ERROR_UNEXPECTED_END,
+    ERROR_MAX_DEPTH,
+    ERROR_UNTERMINATED_CONTAINER,
+    ERROR_INVALID_PATH,
+    // lexer, the bytes are no token
+    ERROR_UNEXPECTED_CHARACTER,
+    ERROR_INVALID_LITERAL,
+    ERROR_INVALID_TOKEN,       // a literal with more letters / digits stuck to it
+    ERROR_UNTERMINATED_STRING,
+    ERROR_NEWLINE_IN_STRING,
+    ERROR_CONTROL_CHARACTER,
+    ERROR_INVALID_UTF8,
+    ERROR_INVALID_ESCAPE,
+    ERROR_INVALID_UNICODE_ESCAPE, // not 4 hex digits after \u
+    ERROR_UNPAIRED_LOW_SURROGATE,
+    ERROR_UNPAIRED_HIGH_SURROGATE,
+    ERROR_NUMBER_MISSING_DIGIT,
+    ERROR_NUMBER_LEADING_ZERO,
+    ERROR_NUMBER_MISSING_FRACTION_DIGIT,
+    ERROR_NUMBER_MISSING_EXPONENT_DIGIT,
+    // binary input (CBOR)
+    ERROR_CBOR_TRUNCATED,
+    ERROR_CBOR_MALFORMED,      // a reserved head, a break out of place
+    ERROR_CBOR_UNSUPPORTED,    // nothing like it in JSON: byte strings, tags, undefined, NaN...
+    ERROR_CBOR_KEY_NOT_STRING,
+    ERROR_CBOR_TRAILING_DATA
+};
+
+// what went wrong and where, recorded without formatting anything or allocating. the text
+// is only put together when someone asks for it: format() into a caller buffer or message()
+struct TrpJsonError
+{
+    TrpErrorCode code;
+    size_t offset;     // bytes from the start of the input (of the whole document when pushed)
+    size_t line;       // 0-based, like tokens
+    size_t col;
+    unsigned expected; // TRP_EXPECT() bits of the tokens that would have been fine, 0 if unknown
+    char detail[TRP_ERROR_DETAIL_BYTES];
+    size_t detail_length;
+
+    TrpJsonError( void );
+    void clear( void );
+    void setDetail( const char* text, size_t length );
+
+    // "Invalid literal: nul", cut to fit and null terminated. returns the full length
+    // like snprintf, so size can be 0 to measure
+    size_t format( char* out, size_t size ) const;
+    std::string message( void ) const;
+    // the fixed part of the message, a static string
+    static const char* describe( TrpErrorCode code );
+};
+
+#endif // TRPJSONERROR_HPP
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "TrpJsonArena.hpp"
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifndef TRPJSONINTERNPOOL_HPP
+#define TRPJSONINTERNPOOL_HPP
+
+// lookups are spread over shards by hash so parsers on other threads rarely wait on each other
+#define TRP_INTERN_SHARDS 16
+#define TRP_INTERN_MAX_LENGTH 64
+#define TRP_INTERN_MAX_ENTRIES (1 << 20)
+
+// only text of TRP_TEXT_INLINE_SIZE (16) to max_length bytes comes here: shorter keys and
+// values live inline in their node and are never looked up, so they are not counted either
+struct TrpInternStats
+{
+    size_t lookups;
+    size_t hits;
+    size_t entries;
+    size_t bytes;  // interned bytes, stored once
+};
+
+// shared immutable copies of keys and short strings, meant to outlive many documents.
+// every AST built with a pool points into it, so the pool has to outlive them all.
+class TrpJsonInternPool {
+    private:
+        struct Entry {
+            const char* data;
+            size_t size;
+            uint32_t hash;
+        };
+
+        struct Shard {
+            pthread_mutex_t lock;
+            TrpJsonArena bytes;
+            std::vector<Entry> table;
+            size_t count;
+            size_t lookups;
+            size_t hits;
+        };
+
+        Shard m_shards[TRP_INTERN_SHARDS];
+        size_t m_max_length;
+        size_t m_max_entries;
+
+        static void grow( Shard& shard );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonInternPool( const TrpJsonInternPool& other );
+        TrpJsonInternPool& operator=( const TrpJsonInternPool& other );
+
+    public:
+        // strings longer than max_length are never interned, past max_entries the pool stops growing
+        TrpJsonInternPool( size_t max_length = TRP_INTERN_MAX_LENGTH, size_t max_entries = TRP_INTERN_MAX_ENTRIES );
+        ~TrpJsonInternPool( void );
+
+        // the shared '\0' terminated copy, NULL when the string is too long or the pool is full
+        const char* intern( const char* data, size_t len );
+
+        size_t maxLength( void ) const;
+        TrpInternStats stats( void );
+        void resetStats( void );
+
+        static uint32_t hash( const char* data, size_t len );
+};
+
+#endif // TRPJSONINTERNPOOL_HPP
@@ -3,6 +3,9 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include "TrpJsonStructuralIndex.hpp"
+#include "TrpJsonNumberParser.hpp"
+#include "TrpJsonError.hpp"
 
 #ifndef TRPJSONLEXER_HPP
 #define TRPJSONLEXER_HPP
@@ -27,37 +30,86 @@ enum TrpTokenType
 struct token
 {
     TrpTokenType type;
+    // only filled in by TrpJsonParser::getLastError(), the lexer never builds a message
     std::string value;
-    size_t line; // 0-based line number
-    size_t col;  // 0-based column number
+    size_t line;   // 0-based line number
+    size_t col;    // 0-based column number
+    size_t offset; // bytes from the start of the input
+
+    // T_ERROR only, what is wrong. text / length are the offending bytes when that says
+    // more (a bad literal, the character after a backslash), length is 0 otherwise
+    TrpErrorCode error;
+
+    // T_STRING: view into the input, or into the lexer scratch when the
+    // string had escapes (that one is only valid until the next token)
+    // T_NUMBER: the lexeme in the input
+    const char* text;
+    size_t length;
+
+    // T_NUMBER only, already converted by the lexer (unless lazy numbers are on)
+    TrpNumber number;
+};
+
+// how the file gets into memory, mmap falls back to buffered if the file can't be mapped (pipes, empty files...)
+// memory means we tokenize a caller owned buffer as is, no file and no copy
+enum TrpLexerInputMode
+{
+    LEXER_INPUT_MMAP,
+    LEXER_INPUT_BUFFERED,
+    LEXER_INPUT_MEMORY
 };
 
-typedef std::string::iterator stringIterator;
 class TrpJsonLexer {
     private:
         // File data
-        std::ifstream json_file;
         std::string file_name;
+        TrpLexerInputMode input_mode;
+        bool is_open;
+        // why the file could not be loaded, nothing is printed
+        TrpErrorCode input_error;
 
-        // Line data
-        bool has_next_line;
-        std::string current_line;
-        std::string next_line;
+        // The whole input lives here, either mapped or read once
+        void* mapped_data;
+        size_t mapped_size;
+        std::vector<char> buffer;
 
-        // Cords for Debugging and Errors
+        const char* input_begin;
+        const char* input_end;
+
+        // Cords for Debugging and Errors, col is current - line_start
         size_t line;
-        size_t col;
+        const char* line_start;
+
+        // Pointer cause it cooler than the iterator
+        const char* current;
 
-        // Iterator cause it cool
-        stringIterator current;
-        stringIterator line_end;
+        // Unescaped strings end up here, only used when there is a backslash
+        std::string string_scratch;
+
+        // Optional stage 1, built on first use then tokens are found by jumping
+        TrpJsonStructuralIndex structural_index;
+        bool use_structural_index;
+        bool structural_index_built;
+        size_t structural_pos;
+
+        // numbers are only validated, not converted (the parser keeps them raw)
+        bool lazy_numbers;
+
+        // Loading the input
+        bool openFile( void );
+        bool mapFile( int fd, size_t file_size );
+        bool readFile( int fd );
+        void releaseInput( void );
 
         // Skipping whitespaces
         void skipWhitespace();
+        void skipToNextStructural();
+        void advanceTo( const char* target );
 
         // Peeking utils
         char peekChar() const;
         char getChar();
+        size_t currentCol() const;
 
         // Lexer controlers
         void advanceLexer();
@@ -65,23 +117,67 @@ class TrpJsonLexer {
 
         // Raw types tokens
         token readString();
+        token readEscapedString( token& t, const char* start );
+        token stringSpecialError( unsigned char c );
+        bool readHex4( unsigned long& cp );
         token readNumber();
         token readLiteral();
-        token createErrorToken(const std::string &message);
+        token createErrorToken(TrpErrorCode code, const char* text = NULL, size_t length = 0);
 
-        // controling lines boundries
-        bool loadNextLineIfNeeded();
-        bool isAtEndOfLine() const;
         bool isAtEnd() const;
 
+        // we do not need copy constructor and copy assignment
+        TrpJsonLexer( const TrpJsonLexer& other );
+        TrpJsonLexer& operator=( const TrpJsonLexer& other );
+
     public:
-        TrpJsonLexer(std::string file_name);
+        TrpJsonLexer(std::string file_name, TrpLexerInputMode mode = LEXER_INPUT_MMAP);
+        // the buffer is borrowed, it has to outlive the lexer
+        TrpJsonLexer(const char* data, size_t len);
         ~TrpJsonLexer(void);
 
         // the holy get next token; minishell refrance lmfao
         token getNextToken(void);
         bool isOpen( void );
+        // ERROR_OPEN_FAILED / ERROR_READ_FAILED when the file could not be loaded
+        TrpErrorCode getInputError( void ) const;
         const std::string getFileName( void ) const;
+        TrpLexerInputMode getInputMode( void ) const;
+        // the whole input as loaded (mapped, read or borrowed), valid while the lexer lives
+        const char* getInput( void ) const;
+        size_t getInputSize( void ) const;
+
+        // SIMD structural index in front of the tokenizer, off by default
+        void setStructuralIndex( bool enabled );
+        bool hasStructuralIndex( void ) const;
+
+        // skip number conversion, T_NUMBER tokens only carry their lexeme
+        void setLazyNumbers( bool enabled );
+        bool hasLazyNumbers( void ) const;
+
+        // on demand parsing. skipContainer() goes past the end of the container whose
+        // open bracket was the last token and returns where it started (NULL if it never
+        // closes), seek() comes back to it later
+        const char* skipContainer( void );
+        void seek( const char* position, size_t line, size_t col );
+        // parallel arrays. skipElements() goes past at least min_bytes of the current array's
+        // elements and stops after the next ',' between elements or the closing ']', returning
+        // it (NULL if the array never closes). position() is where the lexer is in the input
+        const char* skipElements( size_t min_bytes );
+        const char* position( void ) const;
+
+        // another input for the same lexer, the old one is let go (unmapped) but the read
+        // buffer, string scratch and structural index keep their memory. the file one
+        // returns false (and the lexer is closed) when the file can't be loaded
+        void setInput( const char* data, size_t len );
+        bool setInput( const std::string& file_name, TrpLexerInputMode mode = LEXER_INPUT_MMAP );
+
+        // validation without tokens: checks the string whose opening quote is right before p,
+        // returns the byte after its closing quote (NULL if it is not a valid string) and
+        // sets length to what it unescapes to. same rules as the tokenizer
+        static const char* scanString( const char* p, const char* end, size_t& length );
+        // strings that come in binary (CBOR): raw bytes, nothing escaped, only the UTF-8 is checked
+        static bool validUtf8( const char* data, size_t len );
 
         void reset( void );
 };
@@ -90,4 +186,4 @@ class TrpJsonLexer {
 
 // value  → object | array | string | number | true | false | null
 // object → '{' (string ':' value (',' string ':' value)*)? '}'
-// array  → '[' (value (',' value)*)? ']'
\ No newline at end of file
+// array  → '[' (value (',' value)*)? ']'
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef TRPJSONNUMBERFORMAT_HPP
+#define TRPJSONNUMBERFORMAT_HPP
+
+// enough for any double, int64 or uint64 this class writes, sign included
+#define TRP_NUMBER_FORMAT_BYTES 32
+
+// numbers to text without sprintf / iostreams, no locale and no allocation. doubles get the
+// shortest digits that read back to the same double (Grisu2, the digits are shortest for all
+// but a handful of doubles, where there is one more than needed, it still round-trips), laid
+// out like JavaScript does: 100, 0.25, 1.5e-7, 1e+21. integral doubles below 2^53 skip Grisu.
+// out needs TRP_NUMBER_FORMAT_BYTES, nothing is null terminated, the length is returned
+class TrpJsonNumberFormat {
+    private:
+        struct CachedPower
+        {
+            uint64_t f;
+            int e;
+            int k;
+        };
+        static const CachedPower cached_powers[];
+
+        TrpJsonNumberFormat( void );
+
+        static void grisu2( double value, char* digits, int& length, int& exponent );
+        static size_t layout( char* out, const char* digits, int length, int exponent );
+
+    public:
+        // nan and inf have no JSON, they are written as null
+        static size_t formatDouble( double value, char* out );
+        static size_t formatInt64( int64_t value, char* out );
+        static size_t formatUint64( uint64_t value, char* out );
+};
+
+#endif // TRPJSONNUMBERFORMAT_HPP
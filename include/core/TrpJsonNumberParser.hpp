@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef TRPJSONNUMBERPARSER_HPP
+#define TRPJSONNUMBERPARSER_HPP
+
+enum TrpNumberStatus
+{
+    NUMBER_OK,
+    NUMBER_MISSING_DIGIT,          // "-" alone or "-x"
+    NUMBER_LEADING_ZERO,           // 012
+    NUMBER_MISSING_FRACTION_DIGIT, // 1.
+    NUMBER_MISSING_EXPONENT_DIGIT  // 1e, 1e+
+};
+
+// everything the single pass over the lexeme found out
+struct TrpNumber
+{
+    double value;
+    bool negative;
+    bool is_integer;    // no fraction, no exponent and the magnitude fits in 64 bits
+    uint64_t magnitude; // the integer without its sign when is_integer
+};
+
+// validates the JSON number grammar and converts in the same pass, no locale and no allocation.
+// integers take a fast path, decimals go through Clinger's exact fast path then Eisel-Lemire
+// (correctly rounded), strtod is only the fallback for > 19 digit mantissas it can't settle.
+class TrpJsonNumberParser {
+    private:
+        static const uint64_t power_of_five_128[];
+
+        TrpJsonNumberParser( void );
+
+        static bool clingerFastPath( uint64_t w, int64_t q, bool negative, double& out );
+        static void eiselLemire( uint64_t w, int64_t q, uint64_t& mantissa, int32_t& power2 );
+        static double slowPath( const char* start, size_t len );
+
+    public:
+        // parses the longest number prefix of [p, end). length is set to the bytes consumed,
+        // or to the offset where it went wrong when the status is not NUMBER_OK
+        static TrpNumberStatus parse( const char* p, const char* end, TrpNumber& out, size_t& length );
+        // same grammar check without the conversion, for numbers kept raw
+        static TrpNumberStatus scan( const char* p, const char* end, size_t& length );
+        static const char* statusMessage( TrpNumberStatus status );
+};
+
+#endif // TRPJSONNUMBERPARSER_HPP
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef TRPJSONSIMD_HPP
+#define TRPJSONSIMD_HPP
+
+// what the block kernels run on, picked once at runtime from cpuid
+enum TrpSimdLevel
+{
+    TRP_SIMD_SCALAR,
+    TRP_SIMD_SSE2,
+    TRP_SIMD_AVX2
+};
+
+// one bit per byte of a 64 byte block, bit i is block[i]
+struct TrpBlockMasks
+{
+    uint64_t quote;      // "
+    uint64_t backslash;  // \ (and yes it needs two)
+    uint64_t op;         // { } [ ] : ,
+    uint64_t whitespace; // space \t \n \r
+};
+
+#define TRP_SIMD_BLOCK_SIZE 64
+
+class TrpJsonSimd {
+    private:
+        TrpJsonSimd( void );
+
+    public:
+        // best level the cpu supports
+        static TrpSimdLevel detect( void );
+        // level actually used, defaults to detect()
+        static TrpSimdLevel level( void );
+        // force a lower level (benchmarks, checking the fallback), clamped to detect().
+        // not thread safe: only while no parse / writer is running on any thread
+        static void setLevel( TrpSimdLevel level );
+        static const char* levelName( TrpSimdLevel level );
+
+        // block must have TRP_SIMD_BLOCK_SIZE readable bytes
+        static void classifyBlock( const char* block, TrpBlockMasks& masks );
+
+        // offset of the first byte inside a string that needs a closer look:
+        // " \ a control character (< 0x20) or non ascii (>= 0x80), len if there is none
+        static size_t findStringSpecial( const char* data, size_t len );
+};
+
+#endif // TRPJSONSIMD_HPP
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef TRPJSONSTRUCTURALINDEX_HPP
+#define TRPJSONSTRUCTURALINDEX_HPP
+
+// stage 1: one pass over the input, 64 bytes at a time, that records where every token starts.
+// that is { } [ ] : , outside strings, opening quotes and the first byte of every other
+// run of non whitespace (numbers, literals, garbage). the lexer then jumps from token to token.
+class TrpJsonStructuralIndex {
+    private:
+        std::vector<size_t> positions;
+
+        static uint64_t prefixXor( uint64_t bits );
+        static uint64_t findEscaped( uint64_t backslash, uint64_t& prev_escaped );
+
+    public:
+        TrpJsonStructuralIndex( void );
+        ~TrpJsonStructuralIndex( void );
+
+        void build( const char* data, size_t len );
+        // same block scan without an index, for splitting: p is outside any string, returns the
+        // first ']' / '}' closing the container p is in, or the first ',' of that level at or
+        // after cut_from. NULL if the container never closes
+        static const char* findLevelEnd( const char* p, const char* end, const char* cut_from );
+        void clear( void );
+
+        size_t size( void ) const;
+        size_t operator[]( size_t i ) const;
+};
+
+#endif // TRPJSONSTRUCTURALINDEX_HPP
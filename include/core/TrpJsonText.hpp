@@ -0,0 +1,47 @@
+#pragma once
+
+#include "TrpJsonArena.hpp"
+#include "TrpJsonInternPool.hpp"
+#include <cstddef>
+#include <string>
+#include <ostream>
+
+#ifndef TRPJSONTEXT_HPP
+#define TRPJSONTEXT_HPP
+
+// shorter than this the bytes sit in the text itself
+#define TRP_TEXT_INLINE_SIZE 16
+
+// keys, strings and raw numbers. the bytes are either inline, shared (arena or intern pool)
+// or a heap copy. copies are shallow: whoever holds the heap copy calls release() once.
+// data() is always '\0' terminated
+class TrpJsonText {
+    private:
+        union {
+            const char* m_ptr;
+            char m_inline[TRP_TEXT_INLINE_SIZE];
+        };
+        size_t m_size;
+        bool m_owned;
+
+    public:
+        TrpJsonText( void );
+        // inline when it fits, then the pool, then the arena, the heap last
+        TrpJsonText( const char* data, size_t len, TrpJsonArena* arena = NULL, TrpJsonInternPool* pool = NULL );
+
+        // frees the heap copy, nothing to do for the others
+        void release( void );
+
+        const char* data( void ) const {
+            return m_size < TRP_TEXT_INLINE_SIZE ? m_inline : m_ptr;
+        }
+        size_t size( void ) const { return m_size; }
+        bool empty( void ) const { return m_size == 0; }
+
+        bool equals( const char* data, size_t len ) const;
+        std::string str( void ) const;
+};
+
+std::ostream& operator<<( std::ostream& os, const TrpJsonText& text );
+
+#endif // TRPJSONTEXT_HPP
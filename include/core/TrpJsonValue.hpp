@@ -1,18 +1,54 @@
 #pragma once
 
 #include "TrpJsonType.hpp"
+#include "TrpJsonArena.hpp"
+#include <vector>
 
 #ifndef TRPVALUE_HPP
 #define TRPVALUE_HPP
 
 class ITrpJsonValue;
+struct TrpJsonDeferred;
+
+// whoever deferred a container fills it in on first use (the parser does), so the values
+// never have to know about the parser
+class ITrpJsonMaterializer {
+    public:
+        virtual ~ITrpJsonMaterializer( void ) {}
+        // false when the container's text is broken, the materializer keeps the error
+        virtual bool materialize( ITrpJsonValue* container, const TrpJsonDeferred& source ) = 0;
+};
+
+// an on demand container that hasn't been looked into yet: where its text starts
+// (the open bracket, with the line / col the lexer gave it) and who parses it
+struct TrpJsonDeferred
+{
+    ITrpJsonMaterializer* materializer;
+    const char* text;
+    size_t line;
+    size_t col;
+    size_t depth;
+};
 
 class ITrpJsonValue {
     public:
         ITrpJsonValue( void ) {}
         virtual ~ITrpJsonValue( void ) = 0;
         virtual TrpJsonType getType( void ) const = 0;
+
+        // new (arena) TrpJsonXxx(...): the node belongs to the arena, never delete it
+        static void* operator new( size_t size ) { return ::operator new(size); }
+        static void* operator new( size_t size, TrpJsonArena& arena ) { return arena.allocate(size); }
+        static void operator delete( void* p ) { ::operator delete(p); }
+        static void operator delete( void*, TrpJsonArena& ) {}
+
+    protected:
+        // containers hand their children over and forget them
+        virtual void detachChildren( std::vector<ITrpJsonValue*>& out );
+        // deletes the values and everything under them without recursing, deep trees
+        // would blow the stack otherwise
+        static void destroyAll( std::vector<ITrpJsonValue*>& pending );
 };
 
 
-#endif // TRPVALUE_HPP
\ No newline at end of file
+#endif // TRPVALUE_HPP
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../core/TrpJsonValue.hpp"
+#include "../values/TrpJsonNumber.hpp"
+#include "../values/TrpJsonCbor.hpp"
+#include "TrpJsonHandler.hpp"
+#include "TrpJsonOutput.hpp"
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+
+#ifndef TRPJSONCBORWRITER_HPP
+#define TRPJSONCBORWRITER_HPP
+
+// CBOR out of an AST, TrpJsonWriter's binary twin: same sinks, same reusable buffer, no
+// recursion. write() knows every size and picks the smallest encoding: counted arrays and
+// maps, integers in the shortest head that holds them, a float in 4 bytes when that is
+// exact and 8 otherwise.
+// as a handler (parse(writer) turns text straight into CBOR, no AST) the counts are not
+// known when a container starts, so arrays / maps are open ended and closed with a break
+class TrpJsonCborWriter : public ITrpJsonHandler, public TrpJsonOutput {
+    private:
+        // an open container and the next member / element to write
+        struct Frame {
+            ITrpJsonValue* container;
+            size_t next;
+            size_t size;
+            bool is_object;
+        };
+
+        std::vector<Frame> m_stack;
+
+        void bigEndian( unsigned char initial, uint64_t value, size_t bytes );
+        void head( unsigned major, uint64_t argument );
+        void writeText( const char* data, size_t len );
+        void writeInteger( bool negative, uint64_t magnitude );
+        void writeDouble( double value );
+        void writeNumber( const TrpJsonNumber* number );
+        void writeScalar( ITrpJsonValue* value );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonCborWriter( const TrpJsonCborWriter& other );
+        TrpJsonCborWriter& operator=( const TrpJsonCborWriter& other );
+
+    public:
+        TrpJsonCborWriter( void );
+        // the file / fd is borrowed, never closed. the destructor flushes
+        explicit TrpJsonCborWriter( FILE* file );
+        explicit TrpJsonCborWriter( int fd );
+
+        // appends one item, NULL is written as null. false once the sink failed
+        bool write( ITrpJsonValue* value );
+        // buffer sink: keeps the memory for the next document
+        void clear( void );
+
+        // ITrpJsonHandler, each one returns false once the sink failed so the parse stops
+        bool onObjectStart( void );
+        bool onObjectEnd( size_t member_count );
+        bool onArrayStart( void );
+        bool onArrayEnd( size_t element_count );
+        bool onKey( const char* key, size_t len );
+        bool onString( const char* data, size_t len );
+        bool onNumber( const char* lexeme, size_t len, const TrpNumber& number );
+        bool onBool( bool value );
+        bool onNull( void );
+};
+
+#endif // TRPJSONCBORWRITER_HPP
@@ -0,0 +1,16 @@
+#pragma once
+
+#ifndef TRPJSONCOLORS_HPP
+#define TRPJSONCOLORS_HPP
+
+// ANSI colors of the pretty printers, astToString() and a TrpJsonWriter with colors on
+#define RESET       "\033[0m"
+#define STRING_COLOR "\033[31m"      // Red for strings
+#define NUMBER_COLOR "\033[33m"      // Yellow for numbers
+#define BOOL_COLOR   "\033[32m"      // Green for true/false
+#define NULL_COLOR   "\033[35m"      // Magenta for null
+#define KEY_COLOR    "\033[94m"      // Bright blue for keys
+#define BRACE_COLOR  "\033[36m"      // Cyan for {} []
+#define PUNCT_COLOR  "\033[37m"      // White for punctuation
+
+#endif // TRPJSONCOLORS_HPP
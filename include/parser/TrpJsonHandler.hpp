@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include "../core/TrpJsonNumberParser.hpp"
+
+#ifndef TRPJSONHANDLER_HPP
+#define TRPJSONHANDLER_HPP
+
+// events for TrpJsonParser::parse(handler), nothing gets built. every callback returns
+// true to keep going, false stops the parse right there (that is not an error).
+// only override what you need, the rest just says yes.
+// strings and keys point into the input or the lexer scratch, copy them if you keep them
+class ITrpJsonHandler {
+    public:
+        virtual ~ITrpJsonHandler( void ) {}
+
+        virtual bool onObjectStart( void ) { return true; }
+        // member_count / element_count of the container that just closed
+        virtual bool onObjectEnd( size_t member_count ) { (void)member_count; return true; }
+        virtual bool onArrayStart( void ) { return true; }
+        virtual bool onArrayEnd( size_t element_count ) { (void)element_count; return true; }
+
+        virtual bool onKey( const char* key, size_t len ) { (void)key; (void)len; return true; }
+        virtual bool onString( const char* data, size_t len ) { (void)data; (void)len; return true; }
+        // the lexeme is always there, number is only filled when lazy numbers are off
+        virtual bool onNumber( const char* lexeme, size_t len, const TrpNumber& number ) {
+            (void)lexeme; (void)len; (void)number; return true;
+        }
+        virtual bool onBool( bool value ) { (void)value; return true; }
+        virtual bool onNull( void ) { return true; }
+};
+
+#endif // TRPJSONHANDLER_HPP
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "TrpJsonParser.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <pthread.h>
+
+#ifndef TRPJSONLINES_HPP
+#define TRPJSONLINES_HPP
+
+// workers take the input this many bytes at a time (rounded up to the end of a line)
+#define TRP_LINES_CHUNK_BYTES (256 * 1024)
+
+// one line of the input
+struct TrpJsonRecord
+{
+    size_t line;           // 0-based line in the input
+    const char* text;      // the line without its "\n" / "\r\n", points into the input
+    size_t length;
+    ITrpJsonValue* value;  // NULL when the line is not valid JSON, error says why
+    TrpJsonError error;    // line / col / offset of the error are inside the line
+};
+
+class ITrpJsonRecordHandler {
+    public:
+        virtual ~ITrpJsonRecordHandler( void ) {}
+        // false stops the batch. value is only valid during the call, unless the records are
+        // heap trees: then setting record.value to NULL keeps it, and deleting it is yours
+        virtual bool onRecord( TrpJsonRecord& record ) = 0;
+};
+
+enum TrpLinesOrder
+{
+    LINES_ORDERED,   // onRecord() in input order, one call at a time
+    LINES_UNORDERED  // onRecord() from every worker as soon as a line is parsed, concurrently
+};
+
+// NDJSON / JSON Lines: one document per line, blank lines are skipped. lines are parsed in
+// parallel, every worker has its own TrpJsonParser (and arena) and errors are per record,
+// a bad line never stops the batch. ordered delivery keeps a chunk of parsed lines per
+// worker until it is its turn, those are always heap trees
+class TrpJsonLinesParser {
+    private:
+        struct Chunk {
+            const char* begin;
+            const char* end;
+            size_t first_line;
+        };
+
+        // everything the workers share, only touched with lock held
+        struct Batch {
+            TrpJsonLinesParser* owner;
+            ITrpJsonRecordHandler* handler;
+            pthread_mutex_t lock;
+            pthread_cond_t ready;
+            pthread_cond_t turn;
+            std::vector<Chunk> chunks;
+            size_t next_chunk;
+            size_t next_delivery;
+            bool produced;
+            bool stop;
+            size_t records;
+            size_t errors;
+        };
+
+        size_t m_threads;
+        TrpLinesOrder m_order;
+        TrpAllocationMode m_alloc_mode;
+        bool m_lazy_numbers;
+        size_t m_max_depth;
+        TrpJsonInternPool* m_intern_pool;
+
+        size_t m_records;
+        size_t m_errors;
+        bool m_stopped;
+
+        static void* workerMain( void* arg );
+        void work( Batch& batch );
+        bool takeChunk( Batch& batch, Chunk& chunk, size_t& id );
+        void setupParser( TrpJsonParser& parser ) const;
+        void produceChunks( Batch& batch, const char* data, size_t len );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonLinesParser( const TrpJsonLinesParser& other );
+        TrpJsonLinesParser& operator=( const TrpJsonLinesParser& other );
+
+    public:
+        TrpJsonLinesParser( void );
+        ~TrpJsonLinesParser( void );
+
+        // 0 is one worker per online core
+        void setThreads( size_t threads );
+        size_t getThreads( void ) const;
+        void setOrder( TrpLinesOrder order );
+        TrpLinesOrder getOrder( void ) const;
+
+        // passed on to every worker parser, see TrpJsonParser. the pool is the one place
+        // the workers share memory, it has to outlive the kept records
+        void setAllocationMode( TrpAllocationMode mode );
+        void setLazyNumbers( bool enabled );
+        void setMaxDepth( size_t depth );
+        void setInternPool( TrpJsonInternPool* pool );
+
+        // false only when the input can't be read, bad lines are counted in getErrorCount()
+        bool parse( const char* data, size_t len, ITrpJsonRecordHandler& handler );
+        bool parseFile( const std::string& file_name, ITrpJsonRecordHandler& handler );
+
+        // about the last batch. records counts the non blank lines parsed: after a stop the
+        // lines of chunks already taken are still parsed (and unordered, still delivered)
+        size_t getRecordCount( void ) const;
+        size_t getErrorCount( void ) const;
+        bool stoppedEarly( void ) const;
+};
+
+#endif // TRPJSONLINES_HPP
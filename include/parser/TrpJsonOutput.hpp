@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifndef TRPJSONOUTPUT_HPP
+#define TRPJSONOUTPUT_HPP
+
+// size of the buffer in front of a FILE* / fd, it is flushed every time it fills up
+#define TRP_WRITER_BUFFER_BYTES (64 * 1024)
+
+enum TrpWriterSink
+{
+    WRITER_BUFFER, // everything stays in the writer, data() / str()
+    WRITER_FILE,
+    WRITER_FD
+};
+
+// where the writers put their bytes: one buffer that keeps its memory from one document to
+// the next. with the buffer sink it is the whole output, in front of a FILE* / fd it stays
+// small and is written out whenever it is full
+class TrpJsonOutput {
+    protected:
+        TrpWriterSink m_sink;
+        FILE* m_file;
+        int m_fd;
+        std::vector<char> m_buffer;
+        size_t m_size;
+        bool m_failed;
+
+        // the file / fd is borrowed, never closed. the destructor flushes
+        TrpJsonOutput( void );
+        explicit TrpJsonOutput( FILE* file );
+        explicit TrpJsonOutput( int fd );
+        ~TrpJsonOutput( void );
+
+        void grow( size_t len );
+        bool drain( const char* data, size_t len );
+        void put( char c ) {
+            if ( m_size == m_buffer.size() ) grow( 1 );
+            m_buffer[m_size++] = c;
+        }
+        void append( const char* data, size_t len );
+
+    private:
+        // we do not need copy constructor and copy assignment
+        TrpJsonOutput( const TrpJsonOutput& other );
+        TrpJsonOutput& operator=( const TrpJsonOutput& other );
+
+    public:
+        // hands what is buffered to the FILE* / fd, nothing to do for the buffer sink
+        bool flush( void );
+        // false once the sink failed, everything after that is dropped
+        bool failed( void ) const;
+
+        // buffer sink: the bytes so far
+        const char* data( void ) const;
+        size_t size( void ) const;
+        std::string str( void ) const;
+};
+
+#endif // TRPJSONOUTPUT_HPP
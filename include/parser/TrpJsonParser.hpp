@@ -2,6 +2,7 @@
 
 #include "../../include/core/TrpAutoPointer.hpp"
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <cstdlib>
 #include "../core/TrpJsonLexer.hpp"
@@ -12,35 +13,167 @@
 #include "../values/TrpJsonNumber.hpp"
 #include "../values/TrpJsonBool.hpp"
 #include "../values/TrpJsonNull.hpp"
+#include "../values/TrpJsonTape.hpp"
+#include "../values/TrpJsonCbor.hpp"
+#include "TrpJsonHandler.hpp"
+#include "TrpJsonPath.hpp"
+#include "TrpJsonColors.hpp"
 
 #ifndef TRPJSONPARSER_HPP
 #define TRPJSONPARSER_HPP
 
-#define RESET       "\033[0m"
-#define STRING_COLOR "\033[31m"      // Red for strings
-#define NUMBER_COLOR "\033[33m"      // Yellow for numbers
-#define BOOL_COLOR   "\033[32m"      // Green for true/false
-#define NULL_COLOR   "\033[35m"      // Magenta for null
-#define KEY_COLOR    "\033[94m"      // Bright blue for keys
-#define BRACE_COLOR  "\033[36m"      // Cyan for {} []
-#define PUNCT_COLOR  "\033[37m"      // White for punctuation
+// where the AST nodes come from. heap nodes are deleted one by one, arena nodes all go
+// at once when the next document is parsed (or the parser dies)
+enum TrpAllocationMode
+{
+    ALLOC_HEAP,
+    ALLOC_ARENA
+};
+
+// how deep arrays / objects may nest by default, setMaxDepth(0) lifts the limit
+#define TRP_PARSER_MAX_DEPTH 1024
+
+// top level arrays bigger than two of these are split between threads (when there are some),
+// each thread gets at least this many bytes of elements at a time
+#define TRP_PARALLEL_CHUNK_BYTES (1 << 20)
+
+struct TrpParallelBatch;
+
+// where a push parse is, i.e. what the next token may be
+enum TrpPushState
+{
+    PUSH_IDLE,         // no document started, the next feed() starts one
+    PUSH_VALUE,
+    PUSH_FIRST_VALUE,  // right after '[', ']' is fine too
+    PUSH_KEY,
+    PUSH_FIRST_KEY,    // right after '{', '}' is fine too
+    PUSH_COLON,
+    PUSH_AFTER_VALUE,  // ',' or the close of the innermost container
+    PUSH_DONE,         // the root is complete, only whitespace may follow
+    PUSH_FAILED        // the rest is ignored until finish()
+};
 
-class TrpJsonParser {
+// one open array or object, the tree uses container and the tape open / count
+struct TrpParseFrame
+{
+    ITrpJsonValue* container;
+    size_t open;
+    size_t count;
+    bool is_object;
+};
+
+// what validate() found out about a valid document
+struct TrpJsonStats
+{
+    size_t depth;             // deepest array / object nesting, 0 for a scalar document
+    size_t values;            // every value, arrays and objects included (keys are not values)
+    size_t max_string_length; // longest string or key, unescaped bytes
+};
+
+class TrpJsonParser : public ITrpJsonMaterializer {
     private:
         TrpJsonLexer* lexer;
         ITrpJsonValue* head;
         bool parsed;
-        token last_err;
+        TrpJsonError error;
+        // the token view of error for getLastError(), its message is built on the first call
+        mutable token last_err;
+        bool use_structural_index;
+        bool lazy_numbers;
+        TrpAllocationMode alloc_mode;
+        TrpJsonArena arena;
+        TrpJsonInternPool* intern_pool;
+
+        // open containers, kept between parses so the memory is reused
+        std::vector<TrpParseFrame> stack;
+        size_t max_depth;
+        // the last handler parse was cut short by the handler
+        bool stopped;
+        // nested containers are only parsed when they are first looked into
+        bool on_demand;
+        bool has_deferred;
+        // where errors get printed as they happen, NULL (the default) keeps quiet
+        std::ostream* error_stream;
+        // threads for big top level arrays, the helpers parse for them and in arena mode
+        // keep the elements alive until the AST is cleared
+        size_t threads;
+        std::vector<TrpJsonParser*> helpers;
+        // push parsing: the tail of the last chunk that could still be the start of a token,
+        // scanned already (in_string / escaped are the state at its end). line / col / offset
+        // are where the next lexed piece starts, the lexer only sees one piece at a time
+        TrpPushState push_state;
+        TrpJsonText push_key;
+        std::string push_pending;
+        bool push_in_string;
+        bool push_escaped;
+        size_t push_line;
+        size_t push_col;
+        size_t push_offset;
 
+        TrpJsonArena* nodeArena( void );
+        void useInput( const char* data, size_t len );
+        bool checkInput( void );
+        void clearError( void );
+        // records the error at t, the code comes from the token unless one is given.
+        // expected is the TRP_EXPECT() set that would have been fine there
+        void fail( const token& t, unsigned expected, TrpErrorCode code = ERROR_NONE );
 
-        ITrpJsonValue* parseArray( token& current_token );
-        ITrpJsonValue* parseObject( token& current_token );
+        bool pushContainer( token& current_token );
+        bool parseKey( token& current_token, TrpJsonText& key, bool first );
+        void releaseKey( TrpJsonText& key );
+        ITrpJsonValue* parseContainer( bool is_object );
         ITrpJsonValue* parseString( token& current_token );
         ITrpJsonValue* parseNumber( token& current_token );
         ITrpJsonValue* parseLiteral( token& current_token );
 
         ITrpJsonValue* parseValue( token& current_token );
-        
+
+        // tape building, see TrpJsonTapeBuilder.cpp
+        bool tapeValue( token& current_token, TrpJsonTape& tape );
+        bool tapeKey( token& current_token, TrpJsonTape& tape, bool first );
+        void tapeNumber( token& current_token, TrpJsonTape& tape );
+
+        // handler events, see TrpJsonSaxDriver.cpp
+        bool saxValue( token& current_token, ITrpJsonHandler& handler );
+        bool saxKey( token& current_token, ITrpJsonHandler& handler, bool first );
+        bool saxClose( ITrpJsonHandler& handler );
+
+        // validation without tokens, see TrpJsonValidate.cpp
+        bool validateInput( const char* p, const char* end, TrpJsonStats& stats );
+        const char* validateKey( const char* p, const char* end, TrpJsonStats& stats );
+
+        // binary input, see TrpJsonCborDecode.cpp
+        ITrpJsonValue* cborValue( const TrpCborHead& item );
+        bool failCbor( const unsigned char* begin, const unsigned char* at, TrpErrorCode code );
+
+        // on demand documents, see TrpJsonOnDemand.cpp
+        ITrpJsonValue* parseOnDemand( token& current_token );
+        bool parseLevel( token& current_token, ITrpJsonValue* container, size_t depth );
+        ITrpJsonValue* deferContainer( token& current_token, size_t depth );
+        // ITrpJsonMaterializer, deferred containers call back into it
+        bool materialize( ITrpJsonValue* container, const TrpJsonDeferred& source );
+        void materializeAll( void );
+
+        // path queries on raw input, see TrpJsonSelect.cpp
+        bool skipContainer( token& current_token );
+        bool skipValue( token& current_token );
+        bool selectValue( token& current_token, const TrpJsonPath& path, size_t step,
+                TrpJsonArray* matches, ITrpJsonValue*& found );
+
+        // parallel top level arrays, see TrpJsonParallel.cpp
+        bool parallelInput( void ) const;
+        ITrpJsonValue* parseParallel( void );
+        bool parseElements( const char* begin, const char* end, std::vector<ITrpJsonValue*>& out );
+        void releaseHelpers( void );
+        static void* parallelWorker( void* arg );
+
+        // push parsing, see TrpJsonPush.cpp
+        const char* pushScan( const char* p, const char* end, bool first );
+        bool pushSegment( const char* data, size_t len );
+        bool pushToken( token& current_token );
+        bool pushValue( token& current_token );
+        bool pushClose( void );
+        bool failPush( void );
 
     public:
         TrpJsonParser( void );
@@ -50,15 +183,98 @@ class TrpJsonParser {
         void resetLexer( TrpJsonLexer* new_lexer );
         void setLexer( TrpJsonLexer* _lexer);
 
+        // run the SIMD structural index before tokenizing, good for big documents
+        void setStructuralIndex( bool enabled );
+        // keep numbers as their raw text and convert on first getValue(),
+        // worth it when most numbers are just passed along
+        void setLazyNumbers( bool enabled );
+        // deeper documents fail with an error token instead of growing the stack forever
+        void setMaxDepth( size_t depth );
+        size_t getMaxDepth( void ) const;
+        // parse() only checks the top level, nested arrays / objects are skipped by bracket
+        // matching and parsed on their first find() / at() / size(). the input has to stay
+        // alive as long as the AST, errors inside a subtree show up when it is reached
+        // (the container comes back empty and getLastError() says why). not thread safe,
+        // release() parses whatever is left so the tree can outlive the parser
+        void setOnDemand( bool enabled );
+        bool isOnDemand( void ) const;
+        // errors are always kept for getError(), this is only where they also get printed
+        // ("file:line:col Error: message") as they happen. NULL by default, nothing is
+        // formatted or written unless a stream is set
+        void setErrorStream( std::ostream* stream );
+        // a top level array past 2 * TRP_PARALLEL_CHUNK_BYTES is cut between its elements and
+        // the pieces parsed on this many threads, then put back in order in one array.
+        // 1 (the default) never starts a thread, 0 is one per online core. not with on demand
+        void setThreads( size_t threads );
+        size_t getThreads( void ) const;
+
+        // switching drops the current AST. in arena mode the AST is owned by the parser:
+        // don't delete nodes yourself and release() has nothing to give
+        void setAllocationMode( TrpAllocationMode mode );
+        TrpAllocationMode getAllocationMode( void ) const;
+        const TrpJsonArena& getArena( void ) const;
+
+        // keys and strings too long to sit inline but within the pool's max length are shared
+        // through it instead of copied per document. the pool is not owned, can be shared by
+        // parsers on several threads and has to outlive every AST built with it. NULL turns it off
+        void setInternPool( TrpJsonInternPool* pool );
+        TrpJsonInternPool* getInternPool( void ) const;
+
+        // one parser for a stream of documents: every parse() below points the same lexer at
+        // the new input, and the lexer scratch, the read buffer, the container stack and (in
+        // arena mode) the arena all keep their memory. once warmed up, arena parses of
+        // documents no bigger than the ones before don't allocate at all
         bool parse( void );
+        // parse straight from memory, the buffer is not copied so keep it alive
+        bool parse( const char* data, size_t len );
+        // another file, mapped (or read into the buffer the last one used)
+        bool parseFile( const std::string& file_name );
+        bool parseString( const std::string& json );
+        // flat tape instead of a tree, the AST is left alone
+        bool parse( TrpJsonTape& tape );
+        bool parse( const char* data, size_t len, TrpJsonTape& tape );
+        // no tree at all, the handler sees every value as it is read. memory stays O(depth).
+        // a handler stopping early still counts as success, the rest of the input is skipped
+        bool parse( ITrpJsonHandler& handler );
+        bool parse( const char* data, size_t len, ITrpJsonHandler& handler );
+        bool stoppedEarly( void ) const;
+        // is the whole input one valid document, and how big is it. same grammar as parse()
+        // but nothing is built: no token, no node, strings are not unescaped and numbers not
+        // converted. the AST is left alone, getError() says what is wrong as usual
+        bool validate( TrpJsonStats& stats );
+        bool validate( const char* data, size_t len, TrpJsonStats& stats );
+        // the tree out of CBOR (TrpJsonCborWriter's, or any CBOR inside the JSON data model,
+        // see TrpJsonCbor) in the current allocation mode. nothing to tokenize, unescape or
+        // convert: strings are copied as they are and numbers already are binary. the bytes
+        // can go once it returns. errors only have an offset, line and col stay 0
+        bool parseCbor( const char* data, size_t len );
+        // only what the path points at is built, the rest of the input is skipped over (and
+        // only bracket checked). the AST is the match, or NULL when there is none; with a
+        // wildcard it is an array of every match. a single match ends the read right there
+        bool select( const TrpJsonPath& path );
+        bool select( const char* data, size_t len, const TrpJsonPath& path );
+        // push parsing, for input that comes in pieces (network reads): feed() every chunk
+        // as it arrives, cut anywhere (inside a string or a number too), then finish(). the
+        // tree is built as the chunks come and only a token cut by a chunk boundary is copied,
+        // a chunk can go as soon as feed() returns. false once the input is known to be bad,
+        // what follows is ignored until finish(). on demand and threads don't apply here
+        bool feed( const char* data, size_t len );
+        bool finish( void );
         ITrpJsonValue* getAST( void ) const;
 
         bool isParsed( void ) const;                       
+        // why the last parse failed (code ERROR_NONE when it didn't). a plain struct, copying
+        // it around allocates nothing and error.message() is only built when asked for
+        const TrpJsonError& getError( void ) const;
+        // the same error as a token, value holds the message
         const token& getLastError( void ) const;
         void lastError( token t );
         void clearAST( void );
 
         void reset( void );
+        // reset() and give back the memory kept for the next document (arena chunks,
+        // stack, lexer scratch), for after an unusually big one
+        void trim( void );
         ITrpJsonValue* release( void );
 
         std::string astToString( void ) const;
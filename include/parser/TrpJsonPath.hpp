@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../core/TrpJsonValue.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#ifndef TRPJSONPATH_HPP
+#define TRPJSONPATH_HPP
+
+enum TrpPathStepKind
+{
+    PATH_KEY,      // object member, or array element when the key is a valid index
+    PATH_INDEX,    // array element only ("[3]")
+    PATH_WILDCARD  // every member / element
+};
+
+struct TrpPathStep
+{
+    TrpPathStepKind kind;
+    std::string key;
+    size_t index;
+    bool has_index;
+};
+
+// a JSON Pointer (RFC 6901, "/items/0/sku") or a dotted path ("items[0].sku", "items.*.sku")
+// compiled once into steps, then evaluated as many times as needed: against an AST here, or
+// against raw input with TrpJsonParser::select(). keys are compared in place, nothing is
+// copied per lookup. the empty path is the root itself
+class TrpJsonPath {
+    private:
+        std::vector<TrpPathStep> m_steps;
+        bool m_valid;
+        bool m_wildcard;
+        std::string m_error;
+
+        bool fail( const std::string& message, size_t offset );
+        void addKey( const std::string& key, bool indexable );
+        void addIndex( size_t index );
+        void addWildcard( void );
+
+        size_t collect( ITrpJsonValue* root, std::vector<ITrpJsonValue*>& out, bool first_only ) const;
+
+    public:
+        TrpJsonPath( void );
+
+        // false on a malformed path, getError() says where. the previous steps are dropped
+        bool compilePointer( const std::string& pointer );
+        bool compile( const std::string& path );
+
+        bool isValid( void ) const;
+        const std::string& getError( void ) const;
+        bool hasWildcard( void ) const;
+        size_t size( void ) const;
+        const TrpPathStep& step( size_t index ) const;
+
+        // does this step pick the member / element
+        static bool matchesKey( const TrpPathStep& step, const char* key, size_t len );
+        static bool matchesIndex( const TrpPathStep& step, size_t index );
+
+        // first match in document order, NULL if there is none (or the path is invalid)
+        ITrpJsonValue* find( ITrpJsonValue* root ) const;
+        // every match in document order, appended to out, returns how many
+        size_t findAll( ITrpJsonValue* root, std::vector<ITrpJsonValue*>& out ) const;
+};
+
+#endif // TRPJSONPATH_HPP
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../core/TrpJsonValue.hpp"
+#include "../values/TrpJsonNumber.hpp"
+#include "../values/TrpJsonObject.hpp"
+#include "TrpJsonHandler.hpp"
+#include "TrpJsonOutput.hpp"
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifndef TRPJSONWRITER_HPP
+#define TRPJSONWRITER_HPP
+
+enum TrpWriterColors
+{
+    WRITER_COLORS_OFF,
+    WRITER_COLORS_ON,
+    WRITER_COLORS_AUTO // on when the FILE* / fd is a terminal
+};
+
+// JSON text out of an AST: compact by default, setIndent() for one member / element per
+// line, setColors() for the pretty printer's colors. every byte goes straight into the
+// output buffer (TrpJsonOutput), there are no intermediate strings and no recursion (deep
+// trees are fine).
+// it is also a handler: parse(writer) prints the document while it is read, no AST at all
+class TrpJsonWriter : public ITrpJsonHandler, public TrpJsonOutput {
+    private:
+        // an open container and the next member / element to write. sorted objects have
+        // their members at order in m_order
+        struct Frame {
+            ITrpJsonValue* container;
+            size_t next;
+            size_t size;
+            size_t order;
+            bool is_object;
+            bool sorted;
+        };
+
+        size_t m_indent;
+        char m_fill;
+        bool m_colors;
+        bool m_sort_keys;
+        // handler events: a key was written, its value comes next
+        bool m_after_key;
+        std::vector<Frame> m_stack;
+        std::vector<const JsonObjectEntry*> m_order;
+
+        void paint( const char* color );
+        void newline( size_t depth );
+        void open( bool is_object );
+        void close( void );
+        void separate( Frame& frame );
+        void beginValue( void );
+        void writeKey( const char* data, size_t len );
+        void writeString( const char* data, size_t len );
+        void writeNumber( const TrpJsonNumber* number );
+        void writeScalar( ITrpJsonValue* value );
+        void sortMembers( Frame& frame );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonWriter( const TrpJsonWriter& other );
+        TrpJsonWriter& operator=( const TrpJsonWriter& other );
+
+    public:
+        TrpJsonWriter( void );
+        // the file / fd is borrowed, never closed. the destructor flushes
+        explicit TrpJsonWriter( FILE* file );
+        explicit TrpJsonWriter( int fd );
+
+        // fill characters per level, 0 (the default) is compact. '\t' indents with tabs
+        void setIndent( size_t width, char fill = ' ' );
+        size_t getIndent( void ) const;
+        // off by default. auto looks at the sink once, the buffer sink never has colors
+        void setColors( TrpWriterColors mode );
+        bool hasColors( void ) const;
+        // members in key order (bytewise, equal keys keep their order) instead of document
+        // order. only write() can sort, the handler events come one member at a time
+        void setSortKeys( bool enabled );
+        bool getSortKeys( void ) const;
+
+        // appends one document, NULL is written as null. false once the sink failed
+        bool write( ITrpJsonValue* value );
+        // buffer sink: clear() keeps the memory for the next document and forgets a
+        // document the handler events left open
+        void clear( void );
+
+        // ITrpJsonHandler, each one returns false once the sink failed so the parse stops
+        bool onObjectStart( void );
+        bool onObjectEnd( size_t member_count );
+        bool onArrayStart( void );
+        bool onArrayEnd( size_t element_count );
+        bool onKey( const char* key, size_t len );
+        bool onString( const char* data, size_t len );
+        bool onNumber( const char* lexeme, size_t len, const TrpNumber& number );
+        bool onBool( bool value );
+        bool onNull( void );
+};
+
+#endif // TRPJSONWRITER_HPP
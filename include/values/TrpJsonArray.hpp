@@ -9,19 +9,31 @@
 
 class TrpJsonArray;
 
-typedef std::vector<ITrpJsonValue*> JsonArrayVector;
+typedef std::vector<ITrpJsonValue*, TrpJsonArenaAllocator<ITrpJsonValue*> > JsonArrayVector;
 
+// an arena array doesn't own its elements, they go away with the arena.
+// an on demand array parses its elements the first time someone asks for them
 class TrpJsonArray : public ITrpJsonValue {
     private:
         JsonArrayVector m_elements;
+        mutable TrpJsonDeferred* m_deferred;
+
+        void materialize( void ) const;
+
+    protected:
+        void detachChildren( std::vector<ITrpJsonValue*>& out );
 
     public:
-        TrpJsonArray( void );
+        TrpJsonArray( TrpJsonArena* arena = NULL );
         ~TrpJsonArray( void );
         TrpJsonType getType( void ) const;
         void add(ITrpJsonValue* value);
         ITrpJsonValue* at(size_t index);
         size_t size( void ) const;
+
+        // on demand documents, set by the parser
+        void defer( TrpJsonDeferred* source );
+        bool isDeferred( void ) const;
 }; 
 
-#endif // TRPARRAY_HPP
\ No newline at end of file
+#endif // TRPARRAY_HPP
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../core/TrpJsonType.hpp"
+#include "../core/TrpJsonError.hpp"
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef TRPJSONCBOR_HPP
+#define TRPJSONCBOR_HPP
+
+// CBOR (RFC 8949), the part of it JSON can say. an item is a head byte, major type in the
+// top 3 bits and the argument (value, length or count) in the low 5, then for an argument
+// past 23 the argument itself, big endian in 1 / 2 / 4 / 8 bytes
+#define TRP_CBOR_UNSIGNED 0
+#define TRP_CBOR_NEGATIVE 1   // -1 - argument
+#define TRP_CBOR_BYTES 2      // not JSON, rejected
+#define TRP_CBOR_TEXT 3
+#define TRP_CBOR_ARRAY 4
+#define TRP_CBOR_MAP 5        // argument is the number of key / value pairs
+#define TRP_CBOR_TAG 6        // rejected
+#define TRP_CBOR_SIMPLE 7     // false true null and the floats
+
+#define TRP_CBOR_ARGUMENT_8 24
+#define TRP_CBOR_ARGUMENT_64 27
+// arrays and maps without a count go on until a break byte
+#define TRP_CBOR_INDEFINITE 31
+#define TRP_CBOR_BREAK 0xFF
+
+#define TRP_CBOR_FALSE 20
+#define TRP_CBOR_TRUE 21
+#define TRP_CBOR_NULL 22
+#define TRP_CBOR_HALF 25
+#define TRP_CBOR_FLOAT 26
+#define TRP_CBOR_DOUBLE 27
+
+// how deep arrays / maps may nest by default, like the parser
+#define TRP_CBOR_MAX_DEPTH 1024
+
+// items left in an open ended array / map, it is the break that ends it
+#define TRP_CBOR_OPEN_ENDED static_cast<size_t>(-1)
+
+// one decoded head. payload is where a string's bytes start
+struct TrpCborHead
+{
+    unsigned major;
+    unsigned info;     // the low 5 bits, for simple values which one it is
+    uint64_t argument; // floats keep their raw bits here
+    bool indefinite;
+    const unsigned char* payload;
+};
+
+// read only cursor on a checked CBOR item, cheap to copy. nothing is decoded up front:
+// every call reads the head again and strings point straight into the input.
+// like the tape an object's first() is its first key and the value follows the key.
+// going to the next sibling skips the whole subtree (CBOR keeps no end offsets)
+class TrpJsonCborRef {
+    private:
+        const unsigned char* m_item;
+        const unsigned char* m_end;
+        // items of the parent from this one on, TRP_CBOR_OPEN_ENDED when the parent has a break
+        size_t m_left;
+
+        TrpCborHead head( void ) const;
+
+    public:
+        TrpJsonCborRef( void );
+        TrpJsonCborRef( const unsigned char* item, const unsigned char* end, size_t left );
+
+        // false for the ref past the last child (or a failed find / at)
+        bool isValid( void ) const;
+        TrpJsonType getType( void ) const;
+
+        bool getBool( void ) const;
+        double getDouble( void ) const;
+        bool isInteger( void ) const;
+        bool getInt64( int64_t& out ) const;
+        bool getUint64( uint64_t& out ) const;
+
+        // strings (and keys) point into the CBOR bytes, there is no '\0' after them
+        const char* getString( void ) const;
+        size_t getStringLength( void ) const;
+        std::string getValue( void ) const;
+
+        // arrays and objects. open ended ones are counted by walking them
+        size_t size( void ) const;
+        TrpJsonCborRef first( void ) const;
+        TrpJsonCborRef next( void ) const;
+        TrpJsonCborRef at( size_t index ) const;
+        TrpJsonCborRef find( const std::string& key ) const;
+
+        // where the item starts in the input
+        const char* position( void ) const;
+};
+
+// a CBOR document read in place. read() goes over the bytes once and checks everything the
+// refs then take for granted: one well formed item, nothing after it, only what JSON has
+// (no byte strings, tags, undefined, NaN / infinity or open ended strings), text keys and
+// valid UTF-8. nothing is copied, the bytes have to outlive the document and its refs
+class TrpJsonCbor {
+    private:
+        // an open array / map while checking: items (pairs for a map) it still has
+        struct Level {
+            size_t left;
+            bool is_map;
+        };
+
+        const unsigned char* m_data;
+        const unsigned char* m_end;
+        size_t m_max_depth;
+        TrpJsonError m_error;
+        std::vector<Level> m_levels;
+
+        bool fail( const unsigned char* at, TrpErrorCode code );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonCbor( const TrpJsonCbor& other );
+        TrpJsonCbor& operator=( const TrpJsonCbor& other );
+
+    public:
+        TrpJsonCbor( void );
+        ~TrpJsonCbor( void );
+
+        // false (and an invalid root) when the bytes are not a document, getError() says why
+        bool read( const char* data, size_t len );
+        TrpJsonCborRef root( void ) const;
+        const TrpJsonError& getError( void ) const;
+        // deeper documents fail like in the parser, 0 lifts the limit
+        void setMaxDepth( size_t depth );
+        size_t getMaxDepth( void ) const;
+
+        // the wire format, the parser uses it too.
+        // readHead() takes the head at p apart, NULL when it is cut short or reserved.
+        // checkItem() also checks what read() checks about a single item and leaves p after
+        // its head, or after its bytes for a string. a break is an error there
+        static const unsigned char* readHead( const unsigned char* p, const unsigned char* end, TrpCborHead& head );
+        static TrpErrorCode checkItem( const unsigned char*& p, const unsigned char* end, TrpCborHead& head );
+        // the value of a checked number item
+        static double toDouble( const TrpCborHead& head );
+        // past the item at p, which has been checked
+        static const unsigned char* skip( const unsigned char* p, const unsigned char* end );
+};
+
+#endif // TRPJSONCBOR_HPP
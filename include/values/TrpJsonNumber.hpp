@@ -1,19 +1,40 @@
 #pragma once
 
 #include "../core/TrpJsonValue.hpp"
+#include "../core/TrpJsonText.hpp"
+#include "../core/TrpJsonNumberParser.hpp"
+#include <string>
 
 #ifndef TRPJSONNUMBER_HPP
 #define TRPJSONNUMBER_HPP
 
+// integers that fit in 64 bits are kept exact next to the double.
+// a raw number only keeps its lexeme and converts the first time someone asks
 class TrpJsonNumber : public ITrpJsonValue {
     private:
-        double m_value;
-    
+        mutable TrpNumber m_number;
+        mutable bool m_converted;
+        TrpJsonText m_raw;
+
+        void convert( void ) const;
+
     public:
-        TrpJsonNumber(double value) : m_value(value) {}
+        TrpJsonNumber( double value );
+        TrpJsonNumber( const TrpNumber& number );
+        // the lexeme has to be a valid JSON number, the lexer already checked it
+        TrpJsonNumber( const char* lexeme, size_t len, TrpJsonArena* arena = NULL );
         ~TrpJsonNumber( void );
         TrpJsonType getType( void ) const;
         const double& getValue( void ) const;
+
+        // exact integer access, false when the number is not an integer or doesn't fit
+        bool isInteger( void ) const;
+        bool getInt64( int64_t& out ) const;
+        bool getUint64( uint64_t& out ) const;
+
+        // lexeme of a raw number, empty otherwise
+        bool isRaw( void ) const;
+        std::string getRaw( void ) const;
 };
 
-#endif // TRPJSONNUMBER_HPP
\ No newline at end of file
+#endif // TRPJSONNUMBER_HPP
@@ -1,32 +1,62 @@
 #pragma once
 
 #include "../core/TrpJsonValue.hpp"
-#include <map>
+#include "../core/TrpJsonText.hpp"
+#include <vector>
 #include <string>
+#include <stdint.h>
 
 #ifndef TRPOBJECT_HPP
 #define TRPOBJECT_HPP
 
+// past this many members find() stops scanning and goes through the hash index
+#define TRP_OBJECT_HASH_THRESHOLD 16
+
 class TrpJsonObject;
 
-typedef std::map<std::string, ITrpJsonValue*> JsonObjectMap;
-typedef std::pair<std::string, ITrpJsonValue*> JsonObjectEntry;
+typedef std::pair<TrpJsonText, ITrpJsonValue*> JsonObjectEntry;
+typedef std::vector<JsonObjectEntry, TrpJsonArenaAllocator<JsonObjectEntry> > JsonObjectVector;
+typedef std::vector<uint32_t, TrpJsonArenaAllocator<uint32_t> > JsonObjectIndex;
 
+// members sit in one vector in insertion order. small objects are searched linearly,
+// big ones get an open addressing index (member position + 1, 0 is an empty slot).
+// like the array, with an arena everything lives in it and nothing is deleted
 class TrpJsonObject : public ITrpJsonValue {
     private:
-        JsonObjectMap   m_members;
+        JsonObjectVector m_members;
+        JsonObjectIndex  m_index;
+        mutable TrpJsonDeferred* m_deferred;
+
+        void materialize( void ) const;
+
+        static uint32_t hashKey( const char* key, size_t len );
+        size_t findPosition( const char* key, size_t len ) const;
+        void indexMember( size_t position );
+        void rebuildIndex( void );
+
+    protected:
+        void detachChildren( std::vector<ITrpJsonValue*>& out );
 
     public:
-        TrpJsonObject( void );
+        TrpJsonObject( TrpJsonArena* arena = NULL );
         ~TrpJsonObject( void );
         TrpJsonType getType( void ) const;
-        void add(std::string key, ITrpJsonValue* value);
+
+        // a duplicate key replaces the old value and keeps its place
+        void add(const std::string& key, ITrpJsonValue* value);
+        // the key is taken over as is, it has to come from the same arena (or none)
+        void add(const TrpJsonText& key, ITrpJsonValue* value);
         ITrpJsonValue* find(std::string key);
+        ITrpJsonValue* find(const char* key, size_t len);
         
-        // Iterator support for serialization
-        JsonObjectMap::const_iterator begin() const;
-        JsonObjectMap::const_iterator end() const;
+        // Iterator support for serialization, insertion order
+        JsonObjectVector::const_iterator begin() const;
+        JsonObjectVector::const_iterator end() const;
         size_t size() const;
+
+        // on demand documents, set by the parser
+        void defer( TrpJsonDeferred* source );
+        bool isDeferred( void ) const;
 };
 
-#endif // TRPOBJECT_HPP
\ No newline at end of file
+#endif // TRPOBJECT_HPP
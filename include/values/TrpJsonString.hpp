@@ -2,19 +2,29 @@
 
 #include <string>
 #include "../core/TrpJsonValue.hpp"
+#include "../core/TrpJsonText.hpp"
 
 #ifndef TRPJSONSTRING_HPP
 #define TRPJSONSTRING_HPP
 
 class TrpJsonString : public ITrpJsonValue {
     private:
-        std::string m_value;
+        TrpJsonText m_value;
     
     public:
-        TrpJsonString(std::string value) : m_value(value) {}
+        // with an arena the bytes are copied into it, otherwise on the heap.
+        // with a pool short enough strings are shared with every other document using it
+        TrpJsonString(const std::string& value, TrpJsonArena* arena = NULL, TrpJsonInternPool* pool = NULL)
+            : m_value(value.data(), value.size(), arena, pool) {}
+        TrpJsonString(const char* data, size_t len, TrpJsonArena* arena = NULL, TrpJsonInternPool* pool = NULL)
+            : m_value(data, len, arena, pool) {}
         ~TrpJsonString( void );
         TrpJsonType getType( void ) const;
-        const std::string& getValue( void ) const;
+        std::string getValue( void ) const;
+
+        // no copy access
+        const char* data( void ) const;
+        size_t size( void ) const;
 };
 
-#endif // TRPJSONSTRING_HPP
\ No newline at end of file
+#endif // TRPJSONSTRING_HPP
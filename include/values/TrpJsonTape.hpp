@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../core/TrpJsonType.hpp"
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef TRPJSONTAPE_HPP
+#define TRPJSONTAPE_HPP
+
+// one 64 bit word per value: the tag in the top byte, the payload in the low 56 bits
+//   '{' '['  payload = index right after the matching close | child count << 32
+//   '}' ']'  payload = index of the matching open
+//   '"'      payload = offset in the string buffer (uint32 length, bytes, '\0')
+//   'l' 'u' 'd'  int64 / uint64 / double, the raw bits are in the next word
+//   't' 'f' 'n'  no payload
+#define TRP_TAPE_TAG_SHIFT 56
+#define TRP_TAPE_PAYLOAD_MASK 0x00FFFFFFFFFFFFFFULL
+#define TRP_TAPE_INDEX_MASK 0xFFFFFFFFULL
+#define TRP_TAPE_COUNT_MAX 0xFFFFFF
+
+class TrpJsonTape;
+
+// read only cursor on a tape value, cheap to copy around.
+// an array's first() is its first element, an object's first() is its first key and
+// the value follows the key: key.next() is the value, value.next() the next key
+class TrpJsonTapeRef {
+    private:
+        const TrpJsonTape* m_tape;
+        size_t m_index;
+
+    public:
+        TrpJsonTapeRef( void );
+        TrpJsonTapeRef( const TrpJsonTape* tape, size_t index );
+
+        // false for the ref past the last child (or a failed find / at)
+        bool isValid( void ) const;
+        TrpJsonType getType( void ) const;
+
+        bool getBool( void ) const;
+        double getDouble( void ) const;
+        bool isInteger( void ) const;
+        bool getInt64( int64_t& out ) const;
+        bool getUint64( uint64_t& out ) const;
+
+        // strings (and keys) point into the tape string buffer, '\0' terminated
+        const char* getString( void ) const;
+        size_t getStringLength( void ) const;
+        std::string getValue( void ) const;
+
+        // arrays and objects
+        size_t size( void ) const;
+        TrpJsonTapeRef first( void ) const;
+        TrpJsonTapeRef next( void ) const;
+        TrpJsonTapeRef at( size_t index ) const;
+        TrpJsonTapeRef find( const std::string& key ) const;
+
+        size_t getIndex( void ) const;
+};
+
+class TrpJsonTape {
+    private:
+        std::vector<uint64_t> m_tape;
+        std::vector<char> m_strings;
+
+        friend class TrpJsonTapeRef;
+        friend class TrpJsonParser;
+
+        size_t append( char tag, uint64_t payload );
+        void appendNumber( char tag, uint64_t bits );
+        void appendString( const char* data, size_t len );
+        void closeContainer( size_t open, char close_tag, size_t count );
+
+        // we do not need copy constructor and copy assignment
+        TrpJsonTape( const TrpJsonTape& other );
+        TrpJsonTape& operator=( const TrpJsonTape& other );
+
+    public:
+        TrpJsonTape( void );
+        ~TrpJsonTape( void );
+
+        // invalid ref when the tape is empty
+        TrpJsonTapeRef root( void ) const;
+        bool empty( void ) const;
+        void clear( void );
+
+        // words on the tape and bytes in the string buffer
+        size_t tapeSize( void ) const;
+        size_t stringBytes( void ) const;
+
+        static char tagOf( uint64_t word );
+        uint64_t word( size_t index ) const;
+};
+
+#endif // TRPJSONTAPE_HPP
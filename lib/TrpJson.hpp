@@ -28,6 +28,10 @@
 #include <cstddef>
 #include <sstream>
 #include <cstdlib>
+#include <stdint.h>
+#include <new>
+#include <pthread.h>
+#include <cstdio>
 
 // =============================================================================
 // CORE TYPE DEFINITIONS (from core/TrpJsonType.hpp)
@@ -65,19 +69,331 @@ enum TrpTokenType {
     T_ERROR            // Error token
 };
 
+// =============================================================================
+// NUMBER PARSER (from core/TrpJsonNumberParser.hpp)
+// =============================================================================
+
+enum TrpNumberStatus {
+    NUMBER_OK,
+    NUMBER_MISSING_DIGIT,
+    NUMBER_LEADING_ZERO,
+    NUMBER_MISSING_FRACTION_DIGIT,
+    NUMBER_MISSING_EXPONENT_DIGIT
+};
+
+struct TrpNumber {
+    double value;
+    bool negative;
+    bool is_integer;    // no fraction/exponent and fits in 64 bits
+    uint64_t magnitude; // integer without its sign when is_integer
+};
+
+// Single pass validation + correctly rounded conversion (Eisel-Lemire), locale free
+class TrpJsonNumberParser {
+private:
+    static const uint64_t power_of_five_128[];
+
+    TrpJsonNumberParser();
+
+    static bool clingerFastPath(uint64_t w, int64_t q, bool negative, double& out);
+    static void eiselLemire(uint64_t w, int64_t q, uint64_t& mantissa, int32_t& power2);
+    static double slowPath(const char* start, size_t len);
+
+public:
+    static TrpNumberStatus parse(const char* p, const char* end, TrpNumber& out, size_t& length);
+    static TrpNumberStatus scan(const char* p, const char* end, size_t& length);  // grammar only
+    static const char* statusMessage(TrpNumberStatus status);
+};
+
+// =============================================================================
+// NUMBER FORMAT (from core/TrpJsonNumberFormat.hpp)
+// =============================================================================
+
+#define TRP_NUMBER_FORMAT_BYTES 32
+
+// Shortest round-trip doubles (Grisu2), exact integers, no locale. Not null terminated
+class TrpJsonNumberFormat {
+private:
+    struct CachedPower {
+        uint64_t f;
+        int e;
+        int k;
+    };
+    static const CachedPower cached_powers[];
+
+    TrpJsonNumberFormat();
+
+    static void grisu2(double value, char* digits, int& length, int& exponent);
+    static size_t layout(char* out, const char* digits, int length, int exponent);
+
+public:
+    static size_t formatDouble(double value, char* out);  // nan / inf -> null
+    static size_t formatInt64(int64_t value, char* out);
+    static size_t formatUint64(uint64_t value, char* out);
+};
+
+// =============================================================================
+// ERRORS (from core/TrpJsonError.hpp)
+// =============================================================================
+
+#define TRP_ERROR_DETAIL_BYTES 64
+#define TRP_EXPECT(type) (1u << (type))
+#define TRP_EXPECT_VALUE (TRP_EXPECT(T_BRACE_OPEN) | TRP_EXPECT(T_BRACKET_OPEN) | TRP_EXPECT(T_STRING) \
+    | TRP_EXPECT(T_NUMBER) | TRP_EXPECT(T_TRUE) | TRP_EXPECT(T_FALSE) | TRP_EXPECT(T_NULL))
+
+enum TrpErrorCode {
+    ERROR_NONE,
+    ERROR_NO_INPUT,
+    ERROR_OPEN_FAILED,
+    ERROR_READ_FAILED,
+    ERROR_UNEXPECTED_TOKEN,
+    ERROR_UNEXPECTED_END,
+    ERROR_MAX_DEPTH,
+    ERROR_UNTERMINATED_CONTAINER,
+    ERROR_INVALID_PATH,
+    ERROR_UNEXPECTED_CHARACTER,
+    ERROR_INVALID_LITERAL,
+    ERROR_INVALID_TOKEN,
+    ERROR_UNTERMINATED_STRING,
+    ERROR_NEWLINE_IN_STRING,
+    ERROR_CONTROL_CHARACTER,
+    ERROR_INVALID_UTF8,
+    ERROR_INVALID_ESCAPE,
+    ERROR_INVALID_UNICODE_ESCAPE,
+    ERROR_UNPAIRED_LOW_SURROGATE,
+    ERROR_UNPAIRED_HIGH_SURROGATE,
+    ERROR_NUMBER_MISSING_DIGIT,
+    ERROR_NUMBER_LEADING_ZERO,
+    ERROR_NUMBER_MISSING_FRACTION_DIGIT,
+    ERROR_NUMBER_MISSING_EXPONENT_DIGIT,
+    ERROR_CBOR_TRUNCATED,
+    ERROR_CBOR_MALFORMED,
+    ERROR_CBOR_UNSUPPORTED,
+    ERROR_CBOR_KEY_NOT_STRING,
+    ERROR_CBOR_TRAILING_DATA
+};
+
+// What went wrong and where, no allocation. The text is only built by format() / message()
+struct TrpJsonError {
+    TrpErrorCode code;
+    size_t offset;      // bytes into the input
+    size_t line;        // 0-based
+    size_t col;
+    unsigned expected;  // TRP_EXPECT() bits of what would have been fine, 0 if unknown
+    char detail[TRP_ERROR_DETAIL_BYTES];
+    size_t detail_length;
+
+    TrpJsonError();
+    void clear();
+    void setDetail(const char* text, size_t length);
+    size_t format(char* out, size_t size) const;   // snprintf style, cut to fit
+    std::string message() const;
+    static const char* describe(TrpErrorCode code);
+};
+
 // Token structure
 struct token {
     TrpTokenType type;
-    std::string value;
+    std::string value;  // only set by TrpJsonParser::getLastError()
     size_t line;  // 0-based line number
     size_t col;   // 0-based column number
+    size_t offset;  // bytes from the start of the input
+    TrpErrorCode error;  // T_ERROR: what is wrong, text / length the offending bytes (if any)
+    const char* text;   // T_STRING: view into the input (or lexer scratch if escaped), T_NUMBER: lexeme
+    size_t length;
+    TrpNumber number;   // T_NUMBER: converted value
 };
 
+// =============================================================================
+// ARENA (from core/TrpJsonArena.hpp)
+// =============================================================================
+
+#define TRP_ARENA_ALIGNMENT 8
+#define TRP_ARENA_CHUNK_SIZE (64 * 1024)
+
+// Bump allocator for a whole document, reset() drops everything at once
+class TrpJsonArena {
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    Chunk* m_chunks;
+    Chunk* m_spare;    // kept by reset(), used before allocating
+    char* m_cursor;
+    char* m_limit;
+    size_t m_used;
+
+    void* allocateSlow(size_t size);
+    void freeChunks(Chunk* chunk);
+
+    TrpJsonArena(const TrpJsonArena& other);
+    TrpJsonArena& operator=(const TrpJsonArena& other);
+
+public:
+    TrpJsonArena();
+    ~TrpJsonArena();
+
+    void* allocate(size_t size) {
+        size = (size + TRP_ARENA_ALIGNMENT - 1) & ~static_cast<size_t>(TRP_ARENA_ALIGNMENT - 1);
+        if (static_cast<size_t>(m_limit - m_cursor) < size)
+            return allocateSlow(size);
+        void* p = m_cursor;
+        m_cursor += size;
+        m_used += size;
+        return p;
+    }
+
+    void reset();     // keeps every chunk for reuse
+    void release();   // frees everything
+    size_t bytesUsed() const;
+    size_t bytesReserved() const;
+};
+
+// Allocator for the containers inside values, no arena means the heap
+template <typename T>
+class TrpJsonArenaAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef TrpJsonArenaAllocator<U> other;
+    };
+
+    TrpJsonArena* arena;
+
+    TrpJsonArenaAllocator(TrpJsonArena* _arena = NULL) throw() : arena(_arena) {}
+    TrpJsonArenaAllocator(const TrpJsonArenaAllocator& other) throw() : arena(other.arena) {}
+    template <typename U>
+    TrpJsonArenaAllocator(const TrpJsonArenaAllocator<U>& other) throw() : arena(other.arena) {}
+    ~TrpJsonArenaAllocator() throw() {}
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+
+    pointer allocate(size_type n, const void* = 0) {
+        if (arena)
+            return static_cast<pointer>(arena->allocate(n * sizeof(T)));
+        return static_cast<pointer>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type) {
+        if (!arena)
+            ::operator delete(p);
+    }
+
+    size_type max_size() const throw() { return static_cast<size_type>(-1) / sizeof(T); }
+
+    void construct(pointer p, const T& value) { new (static_cast<void*>(p)) T(value); }
+    void destroy(pointer p) { p->~T(); }
+};
+
+template <typename T, typename U>
+inline bool operator==(const TrpJsonArenaAllocator<T>& a, const TrpJsonArenaAllocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const TrpJsonArenaAllocator<T>& a, const TrpJsonArenaAllocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+// =============================================================================
+// INTERN POOL (from core/TrpJsonInternPool.hpp)
+// =============================================================================
+
+#define TRP_INTERN_SHARDS 16
+#define TRP_INTERN_MAX_LENGTH 64
+#define TRP_INTERN_MAX_ENTRIES (1 << 20)
+
+// Only covers text of 16 to max_length bytes, shorter text is inline and never looked up
+struct TrpInternStats {
+    size_t lookups;
+    size_t hits;
+    size_t entries;
+    size_t bytes;
+};
+
+// Shared copies of keys and short strings, thread safe (one lock per shard).
+// Must outlive every AST built with it
+class TrpJsonInternPool {
+private:
+    struct Entry {
+        const char* data;
+        size_t size;
+        uint32_t hash;
+    };
+
+    struct Shard {
+        pthread_mutex_t lock;
+        TrpJsonArena bytes;
+        std::vector<Entry> table;
+        size_t count;
+        size_t lookups;
+        size_t hits;
+    };
+
+    Shard m_shards[TRP_INTERN_SHARDS];
+    size_t m_max_length;
+    size_t m_max_entries;
+
+    static void grow(Shard& shard);
+    TrpJsonInternPool(const TrpJsonInternPool& other);
+    TrpJsonInternPool& operator=(const TrpJsonInternPool& other);
+
+public:
+    TrpJsonInternPool(size_t max_length = TRP_INTERN_MAX_LENGTH, size_t max_entries = TRP_INTERN_MAX_ENTRIES);
+    ~TrpJsonInternPool();
+    const char* intern(const char* data, size_t len);   // NULL when too long or full
+    size_t maxLength() const;
+    TrpInternStats stats();
+    void resetStats();
+    static uint32_t hash(const char* data, size_t len);
+};
+
+// =============================================================================
+// TEXT (from core/TrpJsonText.hpp)
+// =============================================================================
+
+#define TRP_TEXT_INLINE_SIZE 16
+
+// Keys, strings and raw numbers: inline, shared (arena / pool) or a heap copy.
+// Shallow copies, the owner calls release(). data() is '\0' terminated
+class TrpJsonText {
+private:
+    union {
+        const char* m_ptr;
+        char m_inline[TRP_TEXT_INLINE_SIZE];
+    };
+    size_t m_size;
+    bool m_owned;
+
+public:
+    TrpJsonText();
+    TrpJsonText(const char* data, size_t len, TrpJsonArena* arena = NULL, TrpJsonInternPool* pool = NULL);
+    void release();
+    const char* data() const { return m_size < TRP_TEXT_INLINE_SIZE ? m_inline : m_ptr; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    bool equals(const char* data, size_t len) const;
+    std::string str() const;
+};
+
+std::ostream& operator<<(std::ostream& os, const TrpJsonText& text);
+
 // Type definitions for containers
-typedef std::string::iterator stringIterator;
-typedef std::map<std::string, class ITrpJsonValue*> JsonObjectMap;
-typedef std::pair<std::string, class ITrpJsonValue*> JsonObjectEntry;
-typedef std::vector<class ITrpJsonValue*> JsonArrayVector;
+typedef std::pair<TrpJsonText, class ITrpJsonValue*> JsonObjectEntry;
+typedef std::vector<JsonObjectEntry, TrpJsonArenaAllocator<JsonObjectEntry> > JsonObjectVector;
+typedef std::vector<uint32_t, TrpJsonArenaAllocator<uint32_t> > JsonObjectIndex;
+typedef std::vector<class ITrpJsonValue*, TrpJsonArenaAllocator<class ITrpJsonValue*> > JsonArrayVector;
 
 // =============================================================================
 // AUTOPOINTER TEMPLATE (from core/TrpAutoPointer.hpp)
@@ -144,69 +460,143 @@ public:
 // BASE JSON VALUE INTERFACE (from core/TrpJsonValue.hpp)
 // =============================================================================
 
+class ITrpJsonValue;
+struct TrpJsonDeferred;
+
+// Fills a deferred container in on first use, implemented by the parser
+class ITrpJsonMaterializer {
+public:
+    virtual ~ITrpJsonMaterializer() {}
+    virtual bool materialize(ITrpJsonValue* container, const TrpJsonDeferred& source) = 0;
+};
+
+// An on demand container not looked into yet: where its text starts and who parses it
+struct TrpJsonDeferred {
+    ITrpJsonMaterializer* materializer;
+    const char* text;
+    size_t line;
+    size_t col;
+    size_t depth;
+};
+
 class ITrpJsonValue {
 public:
     ITrpJsonValue( void ) {}
     virtual ~ITrpJsonValue( void ) = 0;
     virtual TrpJsonType getType( void ) const = 0;
+
+    // new (arena) TrpJsonXxx(...): the node belongs to the arena, never delete it
+    static void* operator new( size_t size ) { return ::operator new(size); }
+    static void* operator new( size_t size, TrpJsonArena& arena ) { return arena.allocate(size); }
+    static void operator delete( void* p ) { ::operator delete(p); }
+    static void operator delete( void*, TrpJsonArena& ) {}
+
+protected:
+    virtual void detachChildren( std::vector<ITrpJsonValue*>& out );
+    static void destroyAll( std::vector<ITrpJsonValue*>& pending );   // iterative delete
 };
 
 // =============================================================================
 // JSON VALUE CLASSES (from values/*.hpp)
 // =============================================================================
 
-// JSON Object Class
+// JSON Object Class, members in insertion order, hash index past the threshold
+#define TRP_OBJECT_HASH_THRESHOLD 16
+
 class TrpJsonObject : public ITrpJsonValue {
 private:
-    JsonObjectMap m_members;
+    JsonObjectVector m_members;
+    JsonObjectIndex m_index;
+    mutable TrpJsonDeferred* m_deferred;
+
+    void materialize() const;
+
+    static uint32_t hashKey(const char* key, size_t len);
+    size_t findPosition(const char* key, size_t len) const;
+    void indexMember(size_t position);
+    void rebuildIndex();
+
+protected:
+    void detachChildren(std::vector<ITrpJsonValue*>& out);
 
 public:
-    TrpJsonObject();
+    TrpJsonObject(TrpJsonArena* arena = NULL);
     ~TrpJsonObject();
     TrpJsonType getType() const;
-    void add(std::string key, ITrpJsonValue* value);
+    void add(const std::string& key, ITrpJsonValue* value);
+    void add(const TrpJsonText& key, ITrpJsonValue* value);   // takes the key over
     ITrpJsonValue* find(std::string key);
-    JsonObjectMap::const_iterator begin() const;
-    JsonObjectMap::const_iterator end() const;
+    ITrpJsonValue* find(const char* key, size_t len);
+    JsonObjectVector::const_iterator begin() const;
+    JsonObjectVector::const_iterator end() const;
     size_t size() const;
+    void defer(TrpJsonDeferred* source);   // on demand, set by the parser
+    bool isDeferred() const;
 };
 
 // JSON Array Class
 class TrpJsonArray : public ITrpJsonValue {
 private:
     JsonArrayVector m_elements;
+    mutable TrpJsonDeferred* m_deferred;
+
+    void materialize() const;
+
+protected:
+    void detachChildren(std::vector<ITrpJsonValue*>& out);
 
 public:
-    TrpJsonArray();
+    TrpJsonArray(TrpJsonArena* arena = NULL);   // arena arrays don't own their elements
     ~TrpJsonArray();
     TrpJsonType getType() const;
     void add(ITrpJsonValue* value);
     ITrpJsonValue* at(size_t index);
     size_t size() const;
+    void defer(TrpJsonDeferred* source);   // on demand, set by the parser
+    bool isDeferred() const;
 };
 
 // JSON String Class
 class TrpJsonString : public ITrpJsonValue {
 private:
-    std::string m_value;
+    TrpJsonText m_value;
 
 public:
-    TrpJsonString(const std::string& value) : m_value(value) {}
+    TrpJsonString(const std::string& value, TrpJsonArena* arena = NULL, TrpJsonInternPool* pool = NULL)
+        : m_value(value.data(), value.size(), arena, pool) {}
+    TrpJsonString(const char* data, size_t len, TrpJsonArena* arena = NULL, TrpJsonInternPool* pool = NULL)
+        : m_value(data, len, arena, pool) {}
     ~TrpJsonString();
     TrpJsonType getType() const;
-    const std::string& getValue() const;
+    std::string getValue() const;
+    const char* data() const;    // no copy access
+    size_t size() const;
 };
 
 // JSON Number Class
 class TrpJsonNumber : public ITrpJsonValue {
 private:
-    double m_value;
+    mutable TrpNumber m_number;
+    mutable bool m_converted;
+    TrpJsonText m_raw;     // lexeme of a lazy number
+
+    void convert() const;
 
 public:
-    TrpJsonNumber(double value) : m_value(value) {}
+    TrpJsonNumber(double value);
+    TrpJsonNumber(const TrpNumber& number);
+    TrpJsonNumber(const char* lexeme, size_t len, TrpJsonArena* arena = NULL);  // lazy, converted on first access
     ~TrpJsonNumber();
     TrpJsonType getType() const;
     const double& getValue() const;
+
+    // exact 64 bit integers, false when it's not an integer or doesn't fit
+    bool isInteger() const;
+    bool getInt64(int64_t& out) const;
+    bool getUint64(uint64_t& out) const;
+
+    bool isRaw() const;
+    std::string getRaw() const;
 };
 
 // JSON Boolean Class
@@ -227,61 +617,524 @@ public:
     TrpJsonType getType() const;
 };
 
+// =============================================================================
+// TAPE DOCUMENT (from values/TrpJsonTape.hpp)
+// =============================================================================
+
+// One 64 bit word per value, tag in the top byte:
+//   '{' '['  index after the matching close | child count << 32
+//   '}' ']'  index of the matching open
+//   '"'      offset in the string buffer (uint32 length, bytes, '\0')
+//   'l' 'u' 'd'  int64 / uint64 / double, raw bits in the next word
+//   't' 'f' 'n'
+#define TRP_TAPE_TAG_SHIFT 56
+#define TRP_TAPE_PAYLOAD_MASK 0x00FFFFFFFFFFFFFFULL
+#define TRP_TAPE_INDEX_MASK 0xFFFFFFFFULL
+#define TRP_TAPE_COUNT_MAX 0xFFFFFF
+
+class TrpJsonTape;
+
+// Read only cursor on a tape value. object children alternate key, value
+class TrpJsonTapeRef {
+private:
+    const TrpJsonTape* m_tape;
+    size_t m_index;
+
+public:
+    TrpJsonTapeRef();
+    TrpJsonTapeRef(const TrpJsonTape* tape, size_t index);
+
+    bool isValid() const;
+    TrpJsonType getType() const;
+
+    bool getBool() const;
+    double getDouble() const;
+    bool isInteger() const;
+    bool getInt64(int64_t& out) const;
+    bool getUint64(uint64_t& out) const;
+
+    const char* getString() const;
+    size_t getStringLength() const;
+    std::string getValue() const;
+
+    size_t size() const;
+    TrpJsonTapeRef first() const;
+    TrpJsonTapeRef next() const;   // skips subtrees in O(1)
+    TrpJsonTapeRef at(size_t index) const;
+    TrpJsonTapeRef find(const std::string& key) const;
+
+    size_t getIndex() const;
+};
+
+class TrpJsonTape {
+private:
+    std::vector<uint64_t> m_tape;
+    std::vector<char> m_strings;
+
+    friend class TrpJsonTapeRef;
+    friend class TrpJsonParser;
+
+    size_t append(char tag, uint64_t payload);
+    void appendNumber(char tag, uint64_t bits);
+    void appendString(const char* data, size_t len);
+    void closeContainer(size_t open, char close_tag, size_t count);
+
+    TrpJsonTape(const TrpJsonTape& other);
+    TrpJsonTape& operator=(const TrpJsonTape& other);
+
+public:
+    TrpJsonTape();
+    ~TrpJsonTape();
+
+    TrpJsonTapeRef root() const;
+    bool empty() const;
+    void clear();
+    size_t tapeSize() const;
+    size_t stringBytes() const;
+
+    static char tagOf(uint64_t word);
+    uint64_t word(size_t index) const;
+};
+
+// =============================================================================
+// CBOR DOCUMENT (from values/TrpJsonCbor.hpp)
+// =============================================================================
+
+// CBOR (RFC 8949), the part of it JSON can say: head byte = major type << 5 | argument
+#define TRP_CBOR_UNSIGNED 0
+#define TRP_CBOR_NEGATIVE 1   // -1 - argument
+#define TRP_CBOR_BYTES 2      // not JSON, rejected
+#define TRP_CBOR_TEXT 3
+#define TRP_CBOR_ARRAY 4
+#define TRP_CBOR_MAP 5        // argument is the number of key / value pairs
+#define TRP_CBOR_TAG 6        // rejected
+#define TRP_CBOR_SIMPLE 7     // false true null and the floats
+
+#define TRP_CBOR_ARGUMENT_8 24
+#define TRP_CBOR_ARGUMENT_64 27
+#define TRP_CBOR_INDEFINITE 31
+#define TRP_CBOR_BREAK 0xFF
+
+#define TRP_CBOR_FALSE 20
+#define TRP_CBOR_TRUE 21
+#define TRP_CBOR_NULL 22
+#define TRP_CBOR_HALF 25
+#define TRP_CBOR_FLOAT 26
+#define TRP_CBOR_DOUBLE 27
+
+#define TRP_CBOR_MAX_DEPTH 1024
+#define TRP_CBOR_OPEN_ENDED static_cast<size_t>(-1)
+
+struct TrpCborHead {
+    unsigned major;
+    unsigned info;
+    uint64_t argument;
+    bool indefinite;
+    const unsigned char* payload;
+};
+
+// Read only cursor on a checked CBOR item, strings point into the input (no '\0')
+class TrpJsonCborRef {
+private:
+    const unsigned char* m_item;
+    const unsigned char* m_end;
+    size_t m_left;
+
+    TrpCborHead head() const;
+
+public:
+    TrpJsonCborRef();
+    TrpJsonCborRef(const unsigned char* item, const unsigned char* end, size_t left);
+
+    bool isValid() const;
+    TrpJsonType getType() const;
+
+    bool getBool() const;
+    double getDouble() const;
+    bool isInteger() const;
+    bool getInt64(int64_t& out) const;
+    bool getUint64(uint64_t& out) const;
+
+    const char* getString() const;
+    size_t getStringLength() const;
+    std::string getValue() const;
+
+    size_t size() const;
+    TrpJsonCborRef first() const;
+    TrpJsonCborRef next() const;   // skips the whole subtree
+    TrpJsonCborRef at(size_t index) const;
+    TrpJsonCborRef find(const std::string& key) const;
+
+    const char* position() const;
+};
+
+// A CBOR document read in place, read() checks it all once. the bytes have to outlive it
+class TrpJsonCbor {
+private:
+    struct Level {
+        size_t left;
+        bool is_map;
+    };
+
+    const unsigned char* m_data;
+    const unsigned char* m_end;
+    size_t m_max_depth;
+    TrpJsonError m_error;
+    std::vector<Level> m_levels;
+
+    bool fail(const unsigned char* at, TrpErrorCode code);
+
+    TrpJsonCbor(const TrpJsonCbor& other);
+    TrpJsonCbor& operator=(const TrpJsonCbor& other);
+
+public:
+    TrpJsonCbor();
+    ~TrpJsonCbor();
+
+    bool read(const char* data, size_t len);
+    TrpJsonCborRef root() const;
+    const TrpJsonError& getError() const;
+    void setMaxDepth(size_t depth);         // 0 = no limit
+    size_t getMaxDepth() const;
+
+    static const unsigned char* readHead(const unsigned char* p, const unsigned char* end, TrpCborHead& head);
+    static TrpErrorCode checkItem(const unsigned char*& p, const unsigned char* end, TrpCborHead& head);
+    static double toDouble(const TrpCborHead& head);
+    static const unsigned char* skip(const unsigned char* p, const unsigned char* end);
+};
+
+// =============================================================================
+// SIMD DISPATCH (from core/TrpJsonSimd.hpp)
+// =============================================================================
+
+enum TrpSimdLevel {
+    TRP_SIMD_SCALAR,
+    TRP_SIMD_SSE2,
+    TRP_SIMD_AVX2
+};
+
+// One bit per byte of a 64 byte block
+struct TrpBlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;           // { } [ ] : ,
+    uint64_t whitespace;   // space \t \n \r
+};
+
+#define TRP_SIMD_BLOCK_SIZE 64
+
+class TrpJsonSimd {
+private:
+    TrpJsonSimd();
+
+public:
+    static TrpSimdLevel detect();
+    static TrpSimdLevel level();
+    static void setLevel(TrpSimdLevel level);   // only while nothing is parsing
+    static const char* levelName(TrpSimdLevel level);
+    static void classifyBlock(const char* block, TrpBlockMasks& masks);
+    static size_t findStringSpecial(const char* data, size_t len);
+};
+
+// =============================================================================
+// STRUCTURAL INDEX (from core/TrpJsonStructuralIndex.hpp)
+// =============================================================================
+
+// Offsets of every token start, built 64 bytes at a time
+class TrpJsonStructuralIndex {
+private:
+    std::vector<size_t> positions;
+
+    static uint64_t prefixXor(uint64_t bits);
+    static uint64_t findEscaped(uint64_t backslash, uint64_t& prev_escaped);
+
+public:
+    TrpJsonStructuralIndex();
+    ~TrpJsonStructuralIndex();
+    void build(const char* data, size_t len);
+    // first ']' / '}' closing the current level, or its first ',' at or after cut_from
+    static const char* findLevelEnd(const char* p, const char* end, const char* cut_from);
+    void clear();
+    size_t size() const;
+    size_t operator[](size_t i) const;
+};
+
 // =============================================================================
 // LEXER CLASS (from core/TrpJsonLexer.hpp)
 // =============================================================================
 
+// Lexer input modes (mmap falls back to buffered when the file can't be mapped)
+enum TrpLexerInputMode {
+    LEXER_INPUT_MMAP,
+    LEXER_INPUT_BUFFERED,
+    LEXER_INPUT_MEMORY     // caller owned buffer, borrowed as is
+};
+
 class TrpJsonLexer {
 private:
-    std::ifstream json_file;
     std::string file_name;
-    bool has_next_line;
-    std::string current_line;
-    std::string next_line;
+    TrpLexerInputMode input_mode;
+    bool is_open;
+    TrpErrorCode input_error;
+    void* mapped_data;
+    size_t mapped_size;
+    std::vector<char> buffer;
+    const char* input_begin;
+    const char* input_end;
     size_t line;
-    size_t col;
-    stringIterator current;
-    stringIterator line_end;
+    const char* line_start;
+    const char* current;
+    std::string string_scratch;
+    TrpJsonStructuralIndex structural_index;
+    bool use_structural_index;
+    bool structural_index_built;
+    size_t structural_pos;
+    bool lazy_numbers;
 
+    bool openFile();
+    bool mapFile(int fd, size_t file_size);
+    bool readFile(int fd);
+    void releaseInput();
     void skipWhitespace();
+    void skipToNextStructural();
+    void advanceTo(const char* target);
     char peekChar() const;
     char getChar();
+    size_t currentCol() const;
     void advanceLexer();
     void pushBackLexer();
     token readString();
+    token readEscapedString(token& t, const char* start);
+    token stringSpecialError(unsigned char c);
+    bool readHex4(unsigned long& cp);
     token readNumber();
     token readLiteral();
-    token createErrorToken(const std::string& message);
-    bool loadNextLineIfNeeded();
-    bool isAtEndOfLine() const;
+    token createErrorToken(TrpErrorCode code, const char* text = NULL, size_t length = 0);
     bool isAtEnd() const;
 
+    // Disable copy constructor and assignment
+    TrpJsonLexer(const TrpJsonLexer& other);
+    TrpJsonLexer& operator=(const TrpJsonLexer& other);
+
 public:
-    TrpJsonLexer(std::string file_name);
+    TrpJsonLexer(std::string file_name, TrpLexerInputMode mode = LEXER_INPUT_MMAP);
+    TrpJsonLexer(const char* data, size_t len);
     ~TrpJsonLexer();
     token getNextToken();
+    bool isOpen();
+    TrpErrorCode getInputError() const;     // why the file could not be loaded
     const std::string getFileName() const;
+    TrpLexerInputMode getInputMode() const;
+    const char* getInput() const;           // the whole input as loaded
+    size_t getInputSize() const;
+    void setStructuralIndex(bool enabled);
+    bool hasStructuralIndex() const;
+    void setLazyNumbers(bool enabled);
+    bool hasLazyNumbers() const;
+    const char* skipContainer();            // on demand: past the container just opened
+    void seek(const char* position, size_t line, size_t col);
+    const char* skipElements(size_t min_bytes);  // parallel arrays: past the next ',' / ']'
+    const char* position() const;
+    // another input, the read buffer / scratch / index memory stays
+    void setInput(const char* data, size_t len);
+    // validate(): past the string whose quote is before p, NULL if invalid, unescaped length
+    static const char* scanString(const char* p, const char* end, size_t& length);
+    static bool validUtf8(const char* data, size_t len);
+    bool setInput(const std::string& file_name, TrpLexerInputMode mode = LEXER_INPUT_MMAP);
     void reset();
 };
 
+// =============================================================================
+// EVENT HANDLER (from parser/TrpJsonHandler.hpp)
+// =============================================================================
+
+// Callbacks for parse(handler), return false to stop (not an error).
+// Strings and keys are only valid during the call
+class ITrpJsonHandler {
+public:
+    virtual ~ITrpJsonHandler() {}
+    virtual bool onObjectStart() { return true; }
+    virtual bool onObjectEnd(size_t member_count) { (void)member_count; return true; }
+    virtual bool onArrayStart() { return true; }
+    virtual bool onArrayEnd(size_t element_count) { (void)element_count; return true; }
+    virtual bool onKey(const char* key, size_t len) { (void)key; (void)len; return true; }
+    virtual bool onString(const char* data, size_t len) { (void)data; (void)len; return true; }
+    // number is only filled when lazy numbers are off
+    virtual bool onNumber(const char* lexeme, size_t len, const TrpNumber& number) {
+        (void)lexeme; (void)len; (void)number; return true;
+    }
+    virtual bool onBool(bool value) { (void)value; return true; }
+    virtual bool onNull() { return true; }
+};
+
+// =============================================================================
+// PATH QUERIES (from parser/TrpJsonPath.hpp)
+// =============================================================================
+
+enum TrpPathStepKind {
+    PATH_KEY,       // object member, or array element when the key is a valid index
+    PATH_INDEX,     // "[3]", array element only
+    PATH_WILDCARD   // every member / element
+};
+
+struct TrpPathStep {
+    TrpPathStepKind kind;
+    std::string key;
+    size_t index;
+    bool has_index;
+};
+
+// JSON Pointer ("/items/0/sku") or dotted path ("items[0].sku", "items.*.sku"),
+// compiled once and evaluated many times
+class TrpJsonPath {
+private:
+    std::vector<TrpPathStep> m_steps;
+    bool m_valid;
+    bool m_wildcard;
+    std::string m_error;
+
+    bool fail(const std::string& message, size_t offset);
+    void addKey(const std::string& key, bool indexable);
+    void addIndex(size_t index);
+    void addWildcard();
+    size_t collect(ITrpJsonValue* root, std::vector<ITrpJsonValue*>& out, bool first_only) const;
+
+public:
+    TrpJsonPath();
+    bool compilePointer(const std::string& pointer);
+    bool compile(const std::string& path);
+    bool isValid() const;
+    const std::string& getError() const;
+    bool hasWildcard() const;
+    size_t size() const;
+    const TrpPathStep& step(size_t index) const;
+    static bool matchesKey(const TrpPathStep& step, const char* key, size_t len);
+    static bool matchesIndex(const TrpPathStep& step, size_t index);
+    ITrpJsonValue* find(ITrpJsonValue* root) const;       // first match or NULL
+    size_t findAll(ITrpJsonValue* root, std::vector<ITrpJsonValue*>& out) const;
+};
+
 // =============================================================================
 // PARSER CLASS (from parser/TrpJsonParser.hpp)
 // =============================================================================
 
-class TrpJsonParser {
+// Where the AST nodes come from
+enum TrpAllocationMode {
+    ALLOC_HEAP,
+    ALLOC_ARENA     // whole document in one arena, freed at once, owned by the parser
+};
+
+// Default nesting limit, setMaxDepth(0) lifts it
+#define TRP_PARSER_MAX_DEPTH 1024
+
+// Top level arrays past two of these are split between threads
+#define TRP_PARALLEL_CHUNK_BYTES (1 << 20)
+
+struct TrpParallelBatch;
+
+// Where a push parse is, what the next token may be
+enum TrpPushState {
+    PUSH_IDLE,
+    PUSH_VALUE,
+    PUSH_FIRST_VALUE,
+    PUSH_KEY,
+    PUSH_FIRST_KEY,
+    PUSH_COLON,
+    PUSH_AFTER_VALUE,
+    PUSH_DONE,
+    PUSH_FAILED
+};
+
+// One open array / object on the parser's explicit stack
+struct TrpParseFrame {
+    ITrpJsonValue* container;
+    size_t open;
+    size_t count;
+    bool is_object;
+};
+
+// What validate() found out about a valid document
+struct TrpJsonStats {
+    size_t depth;               // deepest nesting, 0 for a scalar document
+    size_t values;              // every value, containers included
+    size_t max_string_length;   // longest string or key, unescaped bytes
+};
+
+class TrpJsonParser : public ITrpJsonMaterializer {
 private:
     TrpJsonLexer* lexer;
     ITrpJsonValue* head;
     bool parsed;
-    token last_err;
+    TrpJsonError error;
+    mutable token last_err;
+    bool use_structural_index;
+    bool lazy_numbers;
+    TrpAllocationMode alloc_mode;
+    TrpJsonArena arena;
+    TrpJsonInternPool* intern_pool;
+    std::vector<TrpParseFrame> stack;
+    size_t max_depth;
+    bool stopped;
+    bool on_demand;
+    bool has_deferred;
+    std::ostream* error_stream;
+    size_t threads;
+    std::vector<TrpJsonParser*> helpers;
+    TrpPushState push_state;
+    TrpJsonText push_key;
+    std::string push_pending;
+    bool push_in_string;
+    bool push_escaped;
+    size_t push_line;
+    size_t push_col;
+    size_t push_offset;
+
+    TrpJsonArena* nodeArena();
+    void useInput(const char* data, size_t len);
+    bool checkInput();
+    void clearError();
+    void fail(const token& t, unsigned expected, TrpErrorCode code = ERROR_NONE);
 
-    ITrpJsonValue* parseArray(token& current_token);
-    ITrpJsonValue* parseObject(token& current_token);
+    bool pushContainer(token& current_token);
+    bool parseKey(token& current_token, TrpJsonText& key, bool first);
+    void releaseKey(TrpJsonText& key);
+    ITrpJsonValue* parseContainer(bool is_object);
     ITrpJsonValue* parseString(token& current_token);
     ITrpJsonValue* parseNumber(token& current_token);
     ITrpJsonValue* parseLiteral(token& current_token);
     ITrpJsonValue* parseValue(token& current_token);
 
+    bool tapeValue(token& current_token, TrpJsonTape& tape);
+    bool tapeKey(token& current_token, TrpJsonTape& tape, bool first);
+    void tapeNumber(token& current_token, TrpJsonTape& tape);
+    bool saxValue(token& current_token, ITrpJsonHandler& handler);
+    bool saxKey(token& current_token, ITrpJsonHandler& handler, bool first);
+    bool saxClose(ITrpJsonHandler& handler);
+    bool validateInput(const char* p, const char* end, TrpJsonStats& stats);
+    const char* validateKey(const char* p, const char* end, TrpJsonStats& stats);
+    ITrpJsonValue* cborValue(const TrpCborHead& item);
+    bool failCbor(const unsigned char* begin, const unsigned char* at, TrpErrorCode code);
+    ITrpJsonValue* parseOnDemand(token& current_token);
+    bool parseLevel(token& current_token, ITrpJsonValue* container, size_t depth);
+    ITrpJsonValue* deferContainer(token& current_token, size_t depth);
+    bool materialize(ITrpJsonValue* container, const TrpJsonDeferred& source);
+    void materializeAll();
+    bool skipContainer(token& current_token);
+    bool skipValue(token& current_token);
+    bool selectValue(token& current_token, const TrpJsonPath& path, size_t step,
+        TrpJsonArray* matches, ITrpJsonValue*& found);
+    bool parallelInput() const;
+    ITrpJsonValue* parseParallel();
+    bool parseElements(const char* begin, const char* end, std::vector<ITrpJsonValue*>& out);
+    void releaseHelpers();
+    static void* parallelWorker(void* arg);
+    const char* pushScan(const char* p, const char* end, bool first);
+    bool pushSegment(const char* data, size_t len);
+    bool pushToken(token& current_token);
+    bool pushValue(token& current_token);
+    bool pushClose();
+    bool failPush();
+
     // Disable copy constructor and assignment
     TrpJsonParser(const TrpJsonParser& other);
     TrpJsonParser& operator=(const TrpJsonParser& other);
@@ -293,17 +1146,313 @@ public:
     
     void resetLexer(TrpJsonLexer* new_lexer);
     void setLexer(TrpJsonLexer* _lexer);
+    void setStructuralIndex(bool enabled);
+    void setLazyNumbers(bool enabled);      // keep numbers raw, convert on first getValue()
+    void setMaxDepth(size_t depth);         // nesting limit, deeper input is an error
+    size_t getMaxDepth() const;
+    // nested containers parsed on first access, the input has to outlive the AST
+    void setOnDemand(bool enabled);
+    bool isOnDemand() const;
+    void setErrorStream(std::ostream* stream);   // also print errors there, NULL (default) = nowhere
+    // big top level arrays parsed on this many threads, 1 = none (default), 0 = one per core
+    void setThreads(size_t threads);
+    size_t getThreads() const;
+    void setAllocationMode(TrpAllocationMode mode);
+    TrpAllocationMode getAllocationMode() const;
+    const TrpJsonArena& getArena() const;
+    // shared key / string pool, not owned, has to outlive the ASTs
+    void setInternPool(TrpJsonInternPool* pool);
+    TrpJsonInternPool* getInternPool() const;
+    // every parse reuses the lexer, stack and arena: no allocations once warmed up (arena mode)
     bool parse();
+    bool parse(const char* data, size_t len);
+    bool parseFile(const std::string& file_name);
+    bool parseString(const std::string& json);
+    bool parse(TrpJsonTape& tape);                               // flat tape instead of a tree
+    bool parse(const char* data, size_t len, TrpJsonTape& tape);
+    bool parse(ITrpJsonHandler& handler);                        // events only, no tree
+    bool parse(const char* data, size_t len, ITrpJsonHandler& handler);
+    bool stoppedEarly() const;                                   // the handler said stop
+    // grammar only, straight over the bytes: nothing built, unescaped or converted
+    bool validate(TrpJsonStats& stats);
+    bool validate(const char* data, size_t len, TrpJsonStats& stats);
+    // the tree out of CBOR in the current allocation mode, errors only have an offset
+    bool parseCbor(const char* data, size_t len);
+    // only the match is built (NULL if none, an array of matches with a wildcard)
+    bool select(const TrpJsonPath& path);
+    bool select(const char* data, size_t len, const TrpJsonPath& path);
+    // push parsing: chunks of any size as they arrive, then finish()
+    bool feed(const char* data, size_t len);
+    bool finish();
     ITrpJsonValue* getAST() const;
     ITrpJsonValue* release();
     bool isParsed() const;
-    const token& getLastError() const;
+    const TrpJsonError& getError() const;        // code ERROR_NONE when nothing failed
+    const token& getLastError() const;           // the same as a token, value is the message
     void lastError(token t);
     void clearAST();
     void reset();
+    void trim();                                                 // reset() + give the kept memory back
     std::string astToString() const;
     void prettyPrint() const;
 };
 
+// =============================================================================
+// NDJSON / JSON LINES (from parser/TrpJsonLines.hpp)
+// =============================================================================
+
+#define TRP_LINES_CHUNK_BYTES (256 * 1024)
+
+struct TrpJsonRecord {
+    size_t line;            // 0-based line in the input
+    const char* text;       // the line without its newline
+    size_t length;
+    ITrpJsonValue* value;   // NULL when the line is not valid JSON
+    TrpJsonError error;     // line / col are inside the line
+};
+
+// false stops the batch. value is only valid during the call, with heap trees
+// setting record.value to NULL keeps it
+class ITrpJsonRecordHandler {
+public:
+    virtual ~ITrpJsonRecordHandler() {}
+    virtual bool onRecord(TrpJsonRecord& record) = 0;
+};
+
+enum TrpLinesOrder {
+    LINES_ORDERED,      // input order, one call at a time
+    LINES_UNORDERED     // as soon as parsed, concurrently from every worker
+};
+
+// One document per line, parsed in parallel, errors per record
+class TrpJsonLinesParser {
+private:
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        size_t first_line;
+    };
+
+    struct Batch {
+        TrpJsonLinesParser* owner;
+        ITrpJsonRecordHandler* handler;
+        pthread_mutex_t lock;
+        pthread_cond_t ready;
+        pthread_cond_t turn;
+        std::vector<Chunk> chunks;
+        size_t next_chunk;
+        size_t next_delivery;
+        bool produced;
+        bool stop;
+        size_t records;
+        size_t errors;
+    };
+
+    size_t m_threads;
+    TrpLinesOrder m_order;
+    TrpAllocationMode m_alloc_mode;
+    bool m_lazy_numbers;
+    size_t m_max_depth;
+    TrpJsonInternPool* m_intern_pool;
+    size_t m_records;
+    size_t m_errors;
+    bool m_stopped;
+
+    static void* workerMain(void* arg);
+    void work(Batch& batch);
+    bool takeChunk(Batch& batch, Chunk& chunk, size_t& id);
+    void setupParser(TrpJsonParser& parser) const;
+    void produceChunks(Batch& batch, const char* data, size_t len);
+
+    // Disable copy constructor and assignment
+    TrpJsonLinesParser(const TrpJsonLinesParser& other);
+    TrpJsonLinesParser& operator=(const TrpJsonLinesParser& other);
+
+public:
+    TrpJsonLinesParser();
+    ~TrpJsonLinesParser();
+    void setThreads(size_t threads);        // 0 = one per core
+    size_t getThreads() const;
+    void setOrder(TrpLinesOrder order);
+    TrpLinesOrder getOrder() const;
+    void setAllocationMode(TrpAllocationMode mode);
+    void setLazyNumbers(bool enabled);
+    void setMaxDepth(size_t depth);
+    void setInternPool(TrpJsonInternPool* pool);
+    bool parse(const char* data, size_t len, ITrpJsonRecordHandler& handler);
+    bool parseFile(const std::string& file_name, ITrpJsonRecordHandler& handler);
+    size_t getRecordCount() const;
+    size_t getErrorCount() const;
+    bool stoppedEarly() const;
+};
+
+// =============================================================================
+// OUTPUT (from parser/TrpJsonOutput.hpp)
+// =============================================================================
+
+#define TRP_WRITER_BUFFER_BYTES (64 * 1024)
+
+enum TrpWriterSink {
+    WRITER_BUFFER,
+    WRITER_FILE,
+    WRITER_FD
+};
+
+// the writers' byte sink: one reusable buffer, or a small one in front of a FILE* / fd
+class TrpJsonOutput {
+protected:
+    TrpWriterSink m_sink;
+    FILE* m_file;
+    int m_fd;
+    std::vector<char> m_buffer;
+    size_t m_size;
+    bool m_failed;
+
+    TrpJsonOutput();
+    explicit TrpJsonOutput(FILE* file);     // borrowed, flushed by the destructor
+    explicit TrpJsonOutput(int fd);
+    ~TrpJsonOutput();
+
+    void grow(size_t len);
+    bool drain(const char* data, size_t len);
+    void put(char c) {
+        if (m_size == m_buffer.size()) grow(1);
+        m_buffer[m_size++] = c;
+    }
+    void append(const char* data, size_t len);
+
+private:
+    // Disable copy constructor and assignment
+    TrpJsonOutput(const TrpJsonOutput& other);
+    TrpJsonOutput& operator=(const TrpJsonOutput& other);
+
+public:
+    bool flush();
+    bool failed() const;
+    const char* data() const;               // buffer sink
+    size_t size() const;
+    std::string str() const;
+};
+
+// =============================================================================
+// WRITER (from parser/TrpJsonWriter.hpp)
+// =============================================================================
+
+enum TrpWriterColors {
+    WRITER_COLORS_OFF,
+    WRITER_COLORS_ON,
+    WRITER_COLORS_AUTO  // on when the FILE* / fd is a terminal
+};
+
+// JSON out of an AST (or parse events), compact or indented, plain or colored, into one
+// reusable buffer or a FILE* / fd
+class TrpJsonWriter : public ITrpJsonHandler, public TrpJsonOutput {
+private:
+    struct Frame {
+        ITrpJsonValue* container;
+        size_t next;
+        size_t size;
+        size_t order;
+        bool is_object;
+        bool sorted;
+    };
+
+    size_t m_indent;
+    char m_fill;
+    bool m_colors;
+    bool m_sort_keys;
+    bool m_after_key;
+    std::vector<Frame> m_stack;
+    std::vector<const JsonObjectEntry*> m_order;
+
+    void paint(const char* color);
+    void newline(size_t depth);
+    void open(bool is_object);
+    void close();
+    void separate(Frame& frame);
+    void beginValue();
+    void writeKey(const char* data, size_t len);
+    void writeString(const char* data, size_t len);
+    void writeNumber(const TrpJsonNumber* number);
+    void writeScalar(ITrpJsonValue* value);
+    void sortMembers(Frame& frame);
+
+    // Disable copy constructor and assignment
+    TrpJsonWriter(const TrpJsonWriter& other);
+    TrpJsonWriter& operator=(const TrpJsonWriter& other);
+
+public:
+    TrpJsonWriter();
+    explicit TrpJsonWriter(FILE* file);     // borrowed, flushed by the destructor
+    explicit TrpJsonWriter(int fd);
+    void setIndent(size_t width, char fill = ' ');  // 0 = compact (default), '\t' for tabs
+    size_t getIndent() const;
+    void setColors(TrpWriterColors mode);   // off by default
+    bool hasColors() const;
+    void setSortKeys(bool enabled);         // write() only
+    bool getSortKeys() const;
+    bool write(ITrpJsonValue* value);       // appends one document
+    void clear();                           // keeps the memory
+
+    // parse(writer) prints while parsing
+    bool onObjectStart();
+    bool onObjectEnd(size_t member_count);
+    bool onArrayStart();
+    bool onArrayEnd(size_t element_count);
+    bool onKey(const char* key, size_t len);
+    bool onString(const char* data, size_t len);
+    bool onNumber(const char* lexeme, size_t len, const TrpNumber& number);
+    bool onBool(bool value);
+    bool onNull();
+};
+
+// =============================================================================
+// CBOR WRITER (from parser/TrpJsonCborWriter.hpp)
+// =============================================================================
+
+// CBOR out of an AST (counted containers, shortest numbers) or parse events (open ended
+// containers), same sinks as TrpJsonWriter
+class TrpJsonCborWriter : public ITrpJsonHandler, public TrpJsonOutput {
+private:
+    struct Frame {
+        ITrpJsonValue* container;
+        size_t next;
+        size_t size;
+        bool is_object;
+    };
+
+    std::vector<Frame> m_stack;
+
+    void bigEndian(unsigned char initial, uint64_t value, size_t bytes);
+    void head(unsigned major, uint64_t argument);
+    void writeText(const char* data, size_t len);
+    void writeInteger(bool negative, uint64_t magnitude);
+    void writeDouble(double value);
+    void writeNumber(const TrpJsonNumber* number);
+    void writeScalar(ITrpJsonValue* value);
+
+    // Disable copy constructor and assignment
+    TrpJsonCborWriter(const TrpJsonCborWriter& other);
+    TrpJsonCborWriter& operator=(const TrpJsonCborWriter& other);
+
+public:
+    TrpJsonCborWriter();
+    explicit TrpJsonCborWriter(FILE* file);  // borrowed, flushed by the destructor
+    explicit TrpJsonCborWriter(int fd);
+    bool write(ITrpJsonValue* value);        // appends one item
+    void clear();                            // keeps the memory
+
+    // parse(writer) turns text into CBOR without a tree
+    bool onObjectStart();
+    bool onObjectEnd(size_t member_count);
+    bool onArrayStart();
+    bool onArrayEnd(size_t element_count);
+    bool onKey(const char* key, size_t len);
+    bool onString(const char* data, size_t len);
+    bool onNumber(const char* lexeme, size_t len, const TrpNumber& number);
+    bool onBool(bool value);
+    bool onNull();
+};
+
 #endif // TRPJSON_HPP
 
@@ -1,18 +1,175 @@
 #include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sstream>
 #include "lib/TrpJson.hpp"
 
-void testParser(const std::string& filename) {
+struct PrintOptions {
+    size_t indent;
+    char fill;
+    TrpWriterColors colors;
+    bool sort_keys;
+};
+
+// printed while it is parsed, memory stays flat whatever the size. sorting needs whole
+// objects, that one goes through the AST. errors wait until the output is out
+int printFile(const std::string& filename, const PrintOptions& options) {
+    TrpJsonParser parser(filename);
+    std::ostringstream errors;
+    parser.setErrorStream(&errors);
+
+    TrpJsonWriter writer(stdout);
+    writer.setIndent(options.indent, options.fill);
+    writer.setColors(options.colors);
+    writer.setSortKeys(options.sort_keys);
+    bool ok;
+    if (options.sort_keys)
+        ok = parser.parse() && writer.write(parser.getAST());
+    else
+        ok = parser.parse(writer) && !parser.stoppedEarly();
+    writer.flush();
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+    std::cerr << errors.str();
+    return ok && !writer.failed() ? 0 : 1;
+}
+
+// only the verdict and how big the document is, nothing gets built
+int validateFile(const std::string& filename) {
+    TrpJsonParser parser(filename);
+    TrpJsonStats stats;
+    if (!parser.validate(stats)) {
+        const TrpJsonError& error = parser.getError();
+        std::cerr << filename << ":" << error.line << ":" << error.col
+                  << " Error: " << error.message() << std::endl;
+        return 1;
+    }
+    std::cout << "valid: depth " << stats.depth << ", values " << stats.values
+              << ", longest string " << stats.max_string_length << std::endl;
+    return 0;
+}
+
+// text straight to CBOR on stdout, no tree in between
+int encodeFile(const std::string& filename) {
     TrpJsonParser parser(filename);
-    
-    if (parser.parse())
-        parser.prettyPrint();
+    TrpJsonCborWriter writer(stdout);
+    bool ok = parser.parse(writer) && !parser.stoppedEarly();
+    writer.flush();
+    std::fflush(stdout);
+    if (!ok && parser.getError().code != ERROR_NONE) {
+        const TrpJsonError& error = parser.getError();
+        std::cerr << filename << ":" << error.line << ":" << error.col
+                  << " Error: " << error.message() << std::endl;
+    }
+    return ok && !writer.failed() ? 0 : 1;
 }
 
+// CBOR back to text, printed like a JSON file
+int decodeFile(const std::string& filename, const PrintOptions& options) {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in) {
+        std::cerr << filename << ": cannot open" << std::endl;
+        return 1;
+    }
+    std::ostringstream bytes;
+    bytes << in.rdbuf();
+    std::string data = bytes.str();
+
+    TrpJsonParser parser;
+    if (!parser.parseCbor(data.data(), data.size())) {
+        std::cerr << filename << ": byte " << parser.getError().offset
+                  << " Error: " << parser.getError().message() << std::endl;
+        return 1;
+    }
+    TrpJsonWriter writer(stdout);
+    writer.setIndent(options.indent, options.fill);
+    writer.setColors(options.colors);
+    writer.setSortKeys(options.sort_keys);
+    writer.write(parser.getAST());
+    writer.flush();
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+    return writer.failed() ? 1 : 0;
+}
+
+// bad lines are reported as they come, in input order
+class LinesReport : public ITrpJsonRecordHandler {
+    public:
+        std::string file_name;
+
+        bool onRecord(TrpJsonRecord& record) {
+            if (!record.value) {
+                char message[256];
+                record.error.format(message, sizeof(message));
+                std::cerr << file_name << ":" << record.line << ":" << record.error.col
+                          << " Error: " << message << std::endl;
+            }
+            return true;
+        }
+};
+
+int testLines(const std::string& filename, size_t threads) {
+    TrpJsonLinesParser lines;
+    LinesReport report;
+    report.file_name = filename;
+
+    lines.setThreads(threads);
+    if (!lines.parseFile(filename, report))
+        return 1;
+    std::cout << "records: " << lines.getRecordCount()
+              << ", errors: " << lines.getErrorCount() << std::endl;
+    return lines.getErrorCount() ? 1 : 0;
+}
+
+// trpjson [--indent n | --tabs] [--color | --no-color] [--sort-keys] file
+// trpjson --ndjson [--threads n] file    one document per line, parsed in parallel
+// trpjson --validate file                 valid or not, depth / values / longest string
+// trpjson --to-cbor file                  the document as CBOR on stdout
+// trpjson [print options] --from-cbor file  a CBOR file printed as JSON
 int main(int ac, char **av) {
-    if (ac != 2) return 1;
+    PrintOptions options;
+    options.indent = 1;
+    options.fill = '\t';
+    options.colors = WRITER_COLORS_AUTO;
+    options.sort_keys = false;
 
-    const std::string validTestFile = av[1];
-    testParser(validTestFile);
-    
-    return 0;
+    bool ndjson = false;
+    bool validate = false;
+    bool to_cbor = false;
+    bool from_cbor = false;
+    size_t threads = 0;
+    int i = 1;
+    for (; i < ac - 1; i++) {
+        if (!std::strcmp(av[i], "--ndjson"))
+            ndjson = true;
+        else if (!std::strcmp(av[i], "--validate"))
+            validate = true;
+        else if (!std::strcmp(av[i], "--to-cbor"))
+            to_cbor = true;
+        else if (!std::strcmp(av[i], "--from-cbor"))
+            from_cbor = true;
+        else if (!std::strcmp(av[i], "--threads") && i + 2 < ac)
+            threads = std::strtoul(av[++i], NULL, 10);
+        else if (!std::strcmp(av[i], "--indent") && i + 2 < ac) {
+            options.indent = std::strtoul(av[++i], NULL, 10);
+            options.fill = ' ';
+        } else if (!std::strcmp(av[i], "--tabs")) {
+            options.indent = 1;
+            options.fill = '\t';
+        } else if (!std::strcmp(av[i], "--color"))
+            options.colors = WRITER_COLORS_ON;
+        else if (!std::strcmp(av[i], "--no-color"))
+            options.colors = WRITER_COLORS_OFF;
+        else if (!std::strcmp(av[i], "--sort-keys"))
+            options.sort_keys = true;
+        else
+            return 1;
+    }
+    if (i != ac - 1) return 1;
+    if (ndjson) return testLines(av[i], threads);
+    if (validate) return validateFile(av[i]);
+    if (to_cbor) return encodeFile(av[i]);
+    if (from_cbor) return decodeFile(av[i], options);
+    return printFile(av[i], options);
 }
@@ -0,0 +1,100 @@
+#include "../../include/core/TrpJsonArena.hpp"
+#include <cstdlib>
+
+// chunks double up to this, past it every new chunk is the same size
+#define TRP_ARENA_MAX_CHUNK_SIZE (16 * 1024 * 1024)
+
+TrpJsonArena::TrpJsonArena( void ) : m_chunks(NULL), m_spare(NULL), m_cursor(NULL), m_limit(NULL), m_used(0) {}
+
+TrpJsonArena::~TrpJsonArena( void ) {
+    freeChunks(m_chunks);
+    freeChunks(m_spare);
+}
+
+void TrpJsonArena::freeChunks( Chunk* chunk ) {
+    while (chunk) {
+        Chunk* next = chunk->next;
+        std::free(chunk);
+        chunk = next;
+    }
+}
+
+// the current chunk is full, the rest of it is lost until the next reset. a spare chunk
+// that fits goes first, only then is a new one allocated
+void* TrpJsonArena::allocateSlow( size_t size ) {
+    Chunk** link = &m_spare;
+    while (*link && (*link)->size < size)
+        link = &(*link)->next;
+
+    Chunk* chunk = *link;
+    if (chunk) {
+        *link = chunk->next;
+    } else {
+        size_t chunk_size = m_chunks ? m_chunks->size * 2 : TRP_ARENA_CHUNK_SIZE;
+        if (chunk_size > TRP_ARENA_MAX_CHUNK_SIZE)
+            chunk_size = TRP_ARENA_MAX_CHUNK_SIZE;
+        if (chunk_size < size)
+            chunk_size = size;
+
+        chunk = static_cast<Chunk*>(std::malloc(sizeof(Chunk) + chunk_size));
+        if (!chunk)
+            throw std::bad_alloc();
+        chunk->size = chunk_size;
+    }
+    chunk->next = m_chunks;
+    m_chunks = chunk;
+
+    char* data = reinterpret_cast<char*>(chunk + 1);
+    m_cursor = data + size;
+    m_limit = data + chunk->size;
+    m_used += size;
+    return data;
+}
+
+void TrpJsonArena::reset( void ) {
+    if (!m_chunks)
+        return;
+
+    Chunk* largest = m_chunks;
+    for (Chunk* c = m_chunks->next; c; c = c->next) {
+        if (c->size > largest->size)
+            largest = c;
+    }
+
+    Chunk* chunk = m_chunks;
+    while (chunk) {
+        Chunk* next = chunk->next;
+        if (chunk != largest) {
+            chunk->next = m_spare;
+            m_spare = chunk;
+        }
+        chunk = next;
+    }
+
+    largest->next = NULL;
+    m_chunks = largest;
+    m_cursor = reinterpret_cast<char*>(largest + 1);
+    m_limit = m_cursor + largest->size;
+    m_used = 0;
+}
+
+void TrpJsonArena::release( void ) {
+    freeChunks(m_chunks);
+    freeChunks(m_spare);
+    m_chunks = m_spare = NULL;
+    m_cursor = m_limit = NULL;
+    m_used = 0;
+}
+
+size_t TrpJsonArena::bytesUsed( void ) const {
+    return m_used;
+}
+
+size_t TrpJsonArena::bytesReserved( void ) const {
+    size_t total = 0;
+    for (Chunk* c = m_chunks; c; c = c->next)
+        total += c->size;
+    for (Chunk* c = m_spare; c; c = c->next)
+        total += c->size;
+    return total;
+}
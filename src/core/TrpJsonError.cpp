@@ -0,0 +1,91 @@
+#include "../../include/core/TrpJsonError.hpp"
+#include <cstring>
+
+TrpJsonError::TrpJsonError( void ) {
+    clear();
+}
+
+void TrpJsonError::clear( void ) {
+    code = ERROR_NONE;
+    offset = 0;
+    line = 0;
+    col = 0;
+    expected = 0;
+    detail_length = 0;
+}
+
+void TrpJsonError::setDetail( const char* text, size_t length ) {
+    if (!text)
+        length = 0;
+    if (length > TRP_ERROR_DETAIL_BYTES)
+        length = TRP_ERROR_DETAIL_BYTES;
+    if (length)
+        std::memcpy(detail, text, length);
+    detail_length = length;
+}
+
+const char* TrpJsonError::describe( TrpErrorCode code ) {
+    switch (code) {
+        case ERROR_NONE: return "";
+        case ERROR_NO_INPUT: return "No file provided";
+        case ERROR_OPEN_FAILED: return "Failed to open file";
+        case ERROR_READ_FAILED: return "Failed to read file";
+        case ERROR_UNEXPECTED_TOKEN: return "Unexpected token";
+        case ERROR_UNEXPECTED_END: return "Unexpected end of input";
+        case ERROR_MAX_DEPTH: return "Maximum nesting depth exceeded";
+        case ERROR_UNTERMINATED_CONTAINER: return "Unterminated array or object";
+        case ERROR_INVALID_PATH: return "Invalid path";
+        case ERROR_UNEXPECTED_CHARACTER: return "Unexpected character";
+        case ERROR_INVALID_LITERAL: return "Invalid literal";
+        case ERROR_INVALID_TOKEN: return "Invalid token";
+        case ERROR_UNTERMINATED_STRING: return "Unterminated string at end of file";
+        case ERROR_NEWLINE_IN_STRING: return "Invalid unescaped newline in string";
+        case ERROR_CONTROL_CHARACTER: return "Invalid control character in string";
+        case ERROR_INVALID_UTF8: return "Invalid UTF-8 in string";
+        case ERROR_INVALID_ESCAPE: return "Invalid escape sequence";
+        case ERROR_INVALID_UNICODE_ESCAPE: return "Invalid unicode escape: expected 4 hex digits after \\u";
+        case ERROR_UNPAIRED_LOW_SURROGATE: return "Invalid unicode escape: unpaired low surrogate";
+        case ERROR_UNPAIRED_HIGH_SURROGATE: return "Invalid unicode escape: unpaired high surrogate";
+        case ERROR_NUMBER_MISSING_DIGIT: return "Invalid number format: minus sign must be followed by a digit";
+        case ERROR_NUMBER_LEADING_ZERO: return "Invalid number format: leading zeros are not allowed";
+        case ERROR_NUMBER_MISSING_FRACTION_DIGIT: return "Invalid number format: decimal point must be followed by at least one digit";
+        case ERROR_NUMBER_MISSING_EXPONENT_DIGIT: return "Invalid number format: exponent must be followed by at least one digit";
+        case ERROR_CBOR_TRUNCATED: return "Unexpected end of CBOR input";
+        case ERROR_CBOR_MALFORMED: return "Malformed CBOR item";
+        case ERROR_CBOR_UNSUPPORTED: return "CBOR item has no JSON equivalent";
+        case ERROR_CBOR_KEY_NOT_STRING: return "CBOR map key is not a text string";
+        case ERROR_CBOR_TRAILING_DATA: return "Unexpected data after the CBOR item";
+    }
+    return "Unknown error";
+}
+
+// the fixed text, then ": " and the detail when there is one (escapes get their backslash back)
+size_t TrpJsonError::format( char* out, size_t size ) const {
+    const char* pieces[3];
+    size_t lengths[3];
+    pieces[0] = describe(code);
+    lengths[0] = std::strlen(pieces[0]);
+    pieces[1] = code == ERROR_INVALID_ESCAPE ? ": \\" : ": ";
+    lengths[1] = detail_length ? std::strlen(pieces[1]) : 0;
+    pieces[2] = detail;
+    lengths[2] = detail_length;
+
+    size_t total = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (size && total < size - 1) {
+            size_t n = lengths[i] < size - 1 - total ? lengths[i] : size - 1 - total;
+            std::memcpy(out + total, pieces[i], n);
+        }
+        total += lengths[i];
+    }
+    if (size)
+        out[total < size - 1 ? total : size - 1] = '\0';
+    return total;
+}
+
+std::string TrpJsonError::message( void ) const {
+    // the longest text plus the longest detail fits
+    char buffer[256];
+    size_t length = format(buffer, sizeof(buffer));
+    return std::string(buffer, length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+}
@@ -0,0 +1,108 @@
+#include "../../include/core/TrpJsonInternPool.hpp"
+#include <cstring>
+
+#define TRP_INTERN_INITIAL_SLOTS 256
+
+TrpJsonInternPool::TrpJsonInternPool( size_t max_length, size_t max_entries )
+    : m_max_length(max_length), m_max_entries(max_entries / TRP_INTERN_SHARDS + 1) {
+    for (size_t i = 0; i < TRP_INTERN_SHARDS; ++i) {
+        Shard& shard = m_shards[i];
+        pthread_mutex_init(&shard.lock, NULL);
+        Entry empty = { NULL, 0, 0 };
+        shard.table.assign(TRP_INTERN_INITIAL_SLOTS, empty);
+        shard.count = shard.lookups = shard.hits = 0;
+    }
+}
+
+TrpJsonInternPool::~TrpJsonInternPool( void ) {
+    for (size_t i = 0; i < TRP_INTERN_SHARDS; ++i)
+        pthread_mutex_destroy(&m_shards[i].lock);
+}
+
+// FNV-1a
+uint32_t TrpJsonInternPool::hash( const char* data, size_t len ) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// entries only point into the shard arena, rehashing moves no bytes
+void TrpJsonInternPool::grow( Shard& shard ) {
+    Entry empty = { NULL, 0, 0 };
+    std::vector<Entry> table(shard.table.size() * 2, empty);
+    size_t mask = table.size() - 1;
+    for (size_t i = 0; i < shard.table.size(); ++i) {
+        const Entry& e = shard.table[i];
+        if (!e.data)
+            continue;
+        size_t slot = (e.hash / TRP_INTERN_SHARDS) & mask;
+        while (table[slot].data)
+            slot = (slot + 1) & mask;
+        table[slot] = e;
+    }
+    shard.table.swap(table);
+}
+
+const char* TrpJsonInternPool::intern( const char* data, size_t len ) {
+    if (len > m_max_length)
+        return NULL;
+
+    uint32_t h = hash(data, len);
+    Shard& shard = m_shards[h % TRP_INTERN_SHARDS];
+    const char* result = NULL;
+
+    pthread_mutex_lock(&shard.lock);
+    ++shard.lookups;
+    size_t mask = shard.table.size() - 1;
+    size_t slot = (h / TRP_INTERN_SHARDS) & mask;
+    for (; shard.table[slot].data; slot = (slot + 1) & mask) {
+        const Entry& e = shard.table[slot];
+        if (e.hash == h && e.size == len && std::memcmp(e.data, data, len) == 0) {
+            ++shard.hits;
+            result = e.data;
+            break;
+        }
+    }
+    if (!result && shard.count < m_max_entries) {
+        char* copy = static_cast<char*>(shard.bytes.allocate(len + 1));
+        std::memcpy(copy, data, len);
+        copy[len] = '\0';
+        Entry e = { copy, len, h };
+        shard.table[slot] = e;
+        result = copy;
+        if (++shard.count * 2 > shard.table.size())
+            grow(shard);
+    }
+    pthread_mutex_unlock(&shard.lock);
+    return result;
+}
+
+size_t TrpJsonInternPool::maxLength( void ) const {
+    return m_max_length;
+}
+
+TrpInternStats TrpJsonInternPool::stats( void ) {
+    TrpInternStats s = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < TRP_INTERN_SHARDS; ++i) {
+        Shard& shard = m_shards[i];
+        pthread_mutex_lock(&shard.lock);
+        s.lookups += shard.lookups;
+        s.hits += shard.hits;
+        s.entries += shard.count;
+        s.bytes += shard.bytes.bytesUsed();
+        pthread_mutex_unlock(&shard.lock);
+    }
+    return s;
+}
+
+void TrpJsonInternPool::resetStats( void ) {
+    for (size_t i = 0; i < TRP_INTERN_SHARDS; ++i) {
+        Shard& shard = m_shards[i];
+        pthread_mutex_lock(&shard.lock);
+        shard.lookups = shard.hits = 0;
+        pthread_mutex_unlock(&shard.lock);
+    }
+}
@@ -1,290 +1,731 @@
 #include "../../include/core/TrpJsonLexer.hpp"
+#include "../../include/core/TrpJsonSimd.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 
-TrpJsonLexer::TrpJsonLexer(std::string _file_name) 
-    : file_name(_file_name), has_next_line(false), current_line(""), line(0), col(0) {
-    json_file.open(file_name.c_str(), std::ios::in);
-    if (!json_file.is_open()) {
-        std::cerr << "Error: Failed to open file: " << file_name << std::endl;
-        return;
+TrpJsonLexer::TrpJsonLexer(std::string _file_name, TrpLexerInputMode mode)
+    : file_name(_file_name), input_mode(mode), is_open(false), input_error(ERROR_NONE),
+      mapped_data(NULL), mapped_size(0),
+      input_begin(NULL), input_end(NULL),
+      line(0), line_start(NULL), current(NULL),
+      use_structural_index(false), structural_index_built(false), structural_pos(0),
+      lazy_numbers(false) {
+    openFile();
+}
+
+// loads file_name the way input_mode says, mmap falls back to reading it. failures are
+// left in input_error for whoever reports them
+bool TrpJsonLexer::openFile( void ) {
+    input_error = ERROR_NONE;
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        input_error = ERROR_OPEN_FAILED;
+        return false;
+    }
+
+    struct stat st;
+    bool loaded = false;
+    if (input_mode == LEXER_INPUT_MMAP && fstat(fd, &st) == 0
+            && S_ISREG(st.st_mode) && st.st_size > 0) {
+        loaded = mapFile(fd, static_cast<size_t>(st.st_size));
+    }
+    if (!loaded) {
+        // pipes, empty files and failed maps all end up here
+        input_mode = LEXER_INPUT_BUFFERED;
+        loaded = readFile(fd);
+    }
+    close(fd);
+
+    if (!loaded) {
+        input_error = ERROR_READ_FAILED;
+        releaseInput();
+        return false;
+    }
+    is_open = true;
+    current = line_start = input_begin;
+    return true;
+}
+
+TrpJsonLexer::TrpJsonLexer(const char* data, size_t len)
+    : file_name("<memory>"), input_mode(LEXER_INPUT_MEMORY), is_open(true), input_error(ERROR_NONE),
+      mapped_data(NULL), mapped_size(0),
+      input_begin(data), input_end(data + len),
+      line(0), line_start(data), current(data),
+      use_structural_index(false), structural_index_built(false), structural_pos(0),
+      lazy_numbers(false) {
+    if (!data) {
+        input_end = NULL;
     }
-    std::getline(json_file, current_line);
-    current = current_line.begin();
-    line_end = current_line.end();
-    has_next_line = static_cast<bool>(std::getline(json_file, next_line));
 }
 
 TrpJsonLexer::~TrpJsonLexer(void) {
-    if (json_file.is_open()) {
-        json_file.close();
+    releaseInput();
+}
+
+bool TrpJsonLexer::mapFile( int fd, size_t file_size ) {
+    void* addr = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+        return false;
+    madvise(addr, file_size, MADV_SEQUENTIAL);
+
+    mapped_data = addr;
+    mapped_size = file_size;
+    input_begin = static_cast<const char*>(addr);
+    input_end = input_begin + file_size;
+    return true;
+}
+
+bool TrpJsonLexer::readFile( int fd ) {
+    struct stat st;
+    size_t used = 0;
+
+    buffer.clear();
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        buffer.resize(static_cast<size_t>(st.st_size));
+    if (buffer.size() == 0)
+        buffer.resize(64 * 1024);
+
+    while (true) {
+        if (used == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        ssize_t n = read(fd, &buffer[used], buffer.size() - used);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (n == 0)
+            break;
+        used += static_cast<size_t>(n);
     }
+    buffer.resize(used);
+
+    input_begin = buffer.empty() ? NULL : &buffer[0];
+    input_end = input_begin + used;
+    return true;
+}
+
+void TrpJsonLexer::releaseInput( void ) {
+    if (mapped_data) {
+        munmap(mapped_data, mapped_size);
+        mapped_data = NULL;
+        mapped_size = 0;
+    }
+    // the read buffer, the scratch and the index keep their memory for the next input
+    buffer.clear();
+    structural_index.clear();
+    structural_index_built = false;
+    structural_pos = 0;
+    input_begin = input_end = current = line_start = NULL;
+    is_open = false;
 }
 
 bool TrpJsonLexer::isOpen( void ) {
-    return json_file.is_open();
+    return is_open;
+}
+
+TrpErrorCode TrpJsonLexer::getInputError( void ) const {
+    return input_error;
 }
 
 const std::string TrpJsonLexer::getFileName( void ) const {
     return file_name;
 }
 
+TrpLexerInputMode TrpJsonLexer::getInputMode( void ) const {
+    return input_mode;
+}
+
+const char* TrpJsonLexer::getInput( void ) const {
+    return input_begin;
+}
+
+size_t TrpJsonLexer::getInputSize( void ) const {
+    return input_end - input_begin;
+}
+
+void TrpJsonLexer::setInput( const char* data, size_t len ) {
+    releaseInput();
+    file_name = "<memory>";
+    input_mode = LEXER_INPUT_MEMORY;
+    input_error = ERROR_NONE;
+    input_begin = data;
+    input_end = data ? data + len : NULL;
+    line = 0;
+    current = line_start = input_begin;
+    is_open = true;
+}
+
+bool TrpJsonLexer::setInput( const std::string& _file_name, TrpLexerInputMode mode ) {
+    releaseInput();
+    file_name = _file_name;
+    input_mode = mode;
+    line = 0;
+    return openFile();
+}
 
+// the input is already in memory so reset is just a rewind
 void TrpJsonLexer::reset( void ) {
-    if (json_file.is_open()) {
-        json_file.close();
+    line = 0;
+    current = line_start = input_begin;
+    structural_pos = 0;
+}
+
+void TrpJsonLexer::setStructuralIndex( bool enabled ) {
+    use_structural_index = enabled;
+    if (!enabled) {
+        structural_index.clear();
+        structural_index_built = false;
     }
-    line = col = 0;
-    json_file.open(file_name.c_str(), std::ios::in);
-    if (!json_file.is_open())
-        return;
-    current_line = "";
-    std::getline(json_file, current_line);
-    current = current_line.begin();
-    line_end = current_line.end();
-    has_next_line = static_cast<bool>(std::getline(json_file, next_line));
-}
-
-bool TrpJsonLexer::loadNextLineIfNeeded() {
-    if (isAtEndOfLine()) {
-        if (has_next_line) {
-            current_line = next_line;
-            has_next_line = static_cast<bool>(std::getline(json_file, next_line));
-            line++;
-            col = 0;
-            current = current_line.begin();
-            line_end = current_line.end();
-            return true;
-        } else {
-            return false;
+    structural_pos = 0;
+}
+
+bool TrpJsonLexer::hasStructuralIndex( void ) const {
+    return use_structural_index;
+}
+
+void TrpJsonLexer::setLazyNumbers( bool enabled ) {
+    lazy_numbers = enabled;
+}
+
+bool TrpJsonLexer::hasLazyNumbers( void ) const {
+    return lazy_numbers;
+}
+
+// moves forward without looking at every byte, memchr finds the newlines for the line count
+void TrpJsonLexer::advanceTo( const char* target ) {
+    while (current < target) {
+        const void* nl = std::memchr(current, '\n', target - current);
+        if (!nl)
+            break;
+        current = static_cast<const char*>(nl) + 1;
+        ++line;
+        line_start = current;
+    }
+    current = target;
+}
+
+// on demand parsing: jumps over the array / object whose open bracket was the last token.
+// only strings and brackets are looked at, what is inside gets checked if it is ever parsed
+const char* TrpJsonLexer::skipContainer( void ) {
+    const char* open = current - 1;
+    const char* p = current;
+    size_t depth = 1;
+
+    while (p < input_end) {
+        char c = *p++;
+        if (c == '"') {
+            bool closed = false;
+            while (p < input_end) {
+                p += TrpJsonSimd::findStringSpecial(p, input_end - p);
+                if (p >= input_end)
+                    break;
+                if (*p == '"') {
+                    closed = true;
+                    ++p;
+                    break;
+                }
+                p += *p == '\\' ? 2 : 1;
+            }
+            if (!closed)
+                return NULL;
+        } else if (c == '[' || c == '{') {
+            ++depth;
+        } else if ((c == ']' || c == '}') && --depth == 0) {
+            advanceTo(p);
+            return open;
         }
     }
-    return true;
+    return NULL;
+}
+
+// parallel arrays: we are inside an array, skips at least min_bytes worth of its elements
+// and stops on the next ',' between two of them, or on the array's own ']'. returns that
+// character and goes past it, NULL if the array never closes
+const char* TrpJsonLexer::skipElements( size_t min_bytes ) {
+    const char* cut_from = static_cast<size_t>(input_end - current) > min_bytes ? current + min_bytes : input_end;
+    const char* cut = TrpJsonStructuralIndex::findLevelEnd(current, input_end, cut_from);
+    if (cut)
+        advanceTo(cut + 1);
+    return cut;
+}
+
+const char* TrpJsonLexer::position( void ) const {
+    return current;
+}
+
+// back to a token we have seen before, with the line / col it had
+void TrpJsonLexer::seek( const char* position, size_t _line, size_t col ) {
+    current = position;
+    line = _line;
+    line_start = position - col;
+    if (!structural_index_built)
+        return;
+
+    size_t offset = position - input_begin;
+    size_t lo = 0;
+    size_t hi = structural_index.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (structural_index[mid] < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    structural_pos = lo;
+}
+
+void TrpJsonLexer::skipToNextStructural() {
+    if (!structural_index_built) {
+        structural_index.build(input_begin, input_end - input_begin);
+        structural_index_built = true;
+        structural_pos = 0;
+    }
+
+    size_t offset = current - input_begin;
+    size_t count = structural_index.size();
+    while (structural_pos < count && structural_index[structural_pos] < offset)
+        ++structural_pos;
+
+    // something glued to the last token (the a in 12a) is not in the index, lex it in place
+    if (current != input_end && *current != ' ' && *current != '\t' && *current != '\n' && *current != '\r'
+            && (structural_pos == count || structural_index[structural_pos] != offset))
+        return;
+
+    if (structural_pos == count) {
+        advanceTo(input_end);
+        return;
+    }
+    advanceTo(input_begin + structural_index[structural_pos++]);
 }
 
 void TrpJsonLexer::skipWhitespace() {
-    while (true) {
-        if (!loadNextLineIfNeeded()) {
+    while (current != input_end) {
+        char c = *current;
+        if (c == ' ' || c == '\t' || c == '\r') {
+            ++current;
+        } else if (c == '\n') {
+            ++current;
+            ++line;
+            line_start = current;
+        } else {
             return;
         }
-        
-        while (current != line_end) {
-            char c = *current;
-            if (c == ' ' || c == '\t' || c == '\r') {
-                advanceLexer();
-            } else {
-                return;
-            }
-        }
     }
 }
 
 char TrpJsonLexer::peekChar() const {
-    if (current == line_end) {
-        if (has_next_line) {
-            return '\n';
-        } else {
-            return '\0';
-        }
+    if (current == input_end) {
+        return '\0';
     }
     return *current;
 }
 
+// a nul byte inside the input is a character like any other, only the end is the end
 char TrpJsonLexer::getChar() {
     char c = peekChar();
-    if (c != '\0') {
-        advanceLexer();
-    }
+    advanceLexer();
     return c;
 }
 
+size_t TrpJsonLexer::currentCol() const {
+    return static_cast<size_t>(current - line_start);
+}
+
 void TrpJsonLexer::advanceLexer() {
-    if (current != line_end) {
+    if (current != input_end) {
         ++current;
-        ++col;
     }
 }
 
 void TrpJsonLexer::pushBackLexer() {
-    if (current != current_line.begin()) {
+    if (current != line_start) {
         --current;
-        --col;
     }
 }
 
-bool TrpJsonLexer::isAtEndOfLine() const {
-    return current == line_end;
-}
-
 bool TrpJsonLexer::isAtEnd() const {
-    return !has_next_line && isAtEndOfLine();
+    return current == input_end;
 }
 
-token TrpJsonLexer::createErrorToken(const std::string& message) {
+// no message here, the code is enough and the text is only formatted if someone asks
+token TrpJsonLexer::createErrorToken(TrpErrorCode code, const char* text, size_t length) {
     token t;
     t.type = T_ERROR;
-    t.value = message;
+    t.error = code;
     t.line = line;
-    t.col = col;
+    t.col = currentCol();
+    t.offset = current - input_begin;
+    t.text = text;
+    t.length = length;
     return t;
 }
 
+// length of the utf-8 sequence at p, 0 if it is not valid (bad continuation, overlong,
+// surrogate, above U+10FFFF or cut by the end of the input)
+static size_t utf8SequenceLength( const unsigned char* p, const unsigned char* end ) {
+    size_t avail = end - p;
+    unsigned char c = p[0];
+
+    if (c < 0x80)
+        return 1;
+    if (c >= 0xC2 && c <= 0xDF) {
+        if (avail < 2 || (p[1] & 0xC0) != 0x80)
+            return 0;
+        return 2;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (avail < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80)
+            return 0;
+        if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] > 0x9F))
+            return 0;
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (avail < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80)
+            return 0;
+        if ((c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] > 0x8F))
+            return 0;
+        return 4;
+    }
+    return 0;
+}
+
+static void appendUtf8( std::string& out, unsigned long cp ) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+static int hexValue( char c ) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// the 4 hex digits after \u, current sits on the first one
+bool TrpJsonLexer::readHex4( unsigned long& cp ) {
+    if (input_end - current < 4)
+        return false;
+    cp = 0;
+    for (int i = 0; i < 4; ++i) {
+        int v = hexValue(current[i]);
+        if (v < 0)
+            return false;
+        cp = (cp << 4) | static_cast<unsigned long>(v);
+    }
+    current += 4;
+    return true;
+}
+
+// anything that stops the SIMD scan and is not a quote or a backslash
+token TrpJsonLexer::stringSpecialError( unsigned char c ) {
+    if (c == '\n')
+        return createErrorToken(ERROR_NEWLINE_IN_STRING);
+    if (c < 0x20)
+        return createErrorToken(ERROR_CONTROL_CHARACTER);
+    return createErrorToken(ERROR_INVALID_UTF8);
+}
+
 token TrpJsonLexer::readString() {
     token t;
     t.type = T_STRING;
     t.line = line;
-    t.col = col - 1;
-    
-    std::string value;
-    bool escaped = false;
-    
+    t.col = currentCol() - 1;
+    t.offset = current - 1 - input_begin;
+    t.error = ERROR_NONE;
+
+    // no escapes means the token is just a view into the input, nothing gets copied.
+    // the scan skips 16/32 bytes at a time and only stops on " \ controls and non ascii
+    const char* start = current;
     while (true) {
-        if (isAtEndOfLine()) {
-                return createErrorToken("Invalid unescaped newline in string");
+        current += TrpJsonSimd::findStringSpecial(current, input_end - current);
+        if (current == input_end)
+            return createErrorToken(ERROR_UNTERMINATED_STRING);
+
+        unsigned char c = static_cast<unsigned char>(*current);
+        if (c == '"') {
+            t.text = start;
+            t.length = current - start;
+            ++current;
+            return t;
         }
-        
-        char c = getChar();
-        
-        if (c == '\0') {
-            return createErrorToken("Unterminated string at end of file");
+        if (c == '\\')
+            return readEscapedString(t, start);
+        if (c < 0x80)
+            return stringSpecialError(c);
+
+        size_t n = utf8SequenceLength(reinterpret_cast<const unsigned char*>(current),
+                                      reinterpret_cast<const unsigned char*>(input_end));
+        if (!n)
+            return stringSpecialError(c);
+        current += n;
+    }
+}
+
+// slow path, unescape into the scratch buffer which keeps its capacity between strings
+token TrpJsonLexer::readEscapedString(token& t, const char* start) {
+    std::string& value = string_scratch;
+    value.assign(start, current - start);
+
+    while (true) {
+        const char* run = current;
+        current += TrpJsonSimd::findStringSpecial(current, input_end - current);
+        value.append(run, current - run);
+        if (current == input_end)
+            return createErrorToken(ERROR_UNTERMINATED_STRING);
+
+        unsigned char c = static_cast<unsigned char>(*current);
+        if (c == '"') {
+            ++current;
+            break;
         }
-        
-        if (escaped) {
-            switch (c) {
-                case '"': value += '"'; break;
-                case '\\': value += '\\'; break;
-                case '/': value += '/'; break;
-                case 'b': value += '\b'; break;
-                case 'f': value += '\f'; break;
-                case 'n': value += '\n'; break;
-                case 'r': value += '\r'; break;
-                case 't': value += '\t'; break;
-                default:
-                    std::string error_msg = "Invalid escape sequence: \\";
-                    error_msg += c;
-                    return createErrorToken(error_msg);
+
+        if (c != '\\') {
+            size_t n = c < 0x80 ? 0 : utf8SequenceLength(reinterpret_cast<const unsigned char*>(current),
+                                                         reinterpret_cast<const unsigned char*>(input_end));
+            if (!n)
+                return stringSpecialError(c);
+            value.append(current, n);
+            current += n;
+            continue;
+        }
+
+        ++current;
+        if (isAtEnd())
+            return createErrorToken(ERROR_UNTERMINATED_STRING);
+        char e = *current;
+        if (e == '\n')
+            return createErrorToken(ERROR_NEWLINE_IN_STRING);
+        ++current;
+        switch (e) {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u': {
+                unsigned long cp;
+                if (!readHex4(cp))
+                    return createErrorToken(ERROR_INVALID_UNICODE_ESCAPE);
+                if (cp >= 0xDC00 && cp <= 0xDFFF)
+                    return createErrorToken(ERROR_UNPAIRED_LOW_SURROGATE);
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // high surrogate, the low half has to follow right away
+                    unsigned long low;
+                    if (input_end - current < 2 || current[0] != '\\' || current[1] != 'u')
+                        return createErrorToken(ERROR_UNPAIRED_HIGH_SURROGATE);
+                    current += 2;
+                    if (!readHex4(low))
+                        return createErrorToken(ERROR_INVALID_UNICODE_ESCAPE);
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        return createErrorToken(ERROR_UNPAIRED_HIGH_SURROGATE);
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(value, cp);
+                break;
             }
-            escaped = false;
-        } else if (c == '\\') {
-            escaped = true;
-        } else if (c == '"') {
-            break;
-        } else {
-            value += c;
+            default:
+                return createErrorToken(ERROR_INVALID_ESCAPE, current - 1, 1);
         }
     }
-    
-    t.value = value;
+
+    t.text = value.data();
+    t.length = value.size();
     return t;
 }
 
-token TrpJsonLexer::readNumber() {
-    token t;
-    t.type = T_NUMBER;
-    t.line = line;
-    t.col = col - 1;
-    
-    std::string value;
-    pushBackLexer();
-    char first_digit = *current;
-    advanceLexer();
-    value += first_digit;
-    
-    if (first_digit == '0' && !isAtEndOfLine() && isdigit(peekChar())) {
-        return createErrorToken("Invalid number format: leading zeros are not allowed");
-    }
-    
-    bool has_decimal = false;
-    bool has_exponent = false;
-    bool has_digit_after_decimal = false;
-    bool has_digit_after_exponent = false;
-    
-    while (!isAtEndOfLine()) {
-        char c = peekChar();
-        
-        if (isdigit(c)) {
-            value += getChar();
-            if (has_decimal && !has_digit_after_decimal) {
-                has_digit_after_decimal = true;
-            }
-            if (has_exponent && !has_digit_after_exponent) {
-                has_digit_after_exponent = true;
+// the grammar of readString() / readEscapedString() without a token, a position or a copy.
+// only the unescaped length is counted. p is right after the opening quote
+const char* TrpJsonLexer::scanString( const char* p, const char* end, size_t& length ) {
+    length = 0;
+    while (true) {
+        const char* run = p;
+        p += TrpJsonSimd::findStringSpecial(p, end - p);
+        length += p - run;
+        if (p == end)
+            return NULL;
+
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"')
+            return p + 1;
+        if (c != '\\') {
+            size_t n = c < 0x80 ? 0 : utf8SequenceLength(reinterpret_cast<const unsigned char*>(p),
+                                                         reinterpret_cast<const unsigned char*>(end));
+            if (!n)
+                return NULL;
+            length += n;
+            p += n;
+            continue;
+        }
+
+        if (end - p < 2)
+            return NULL;
+        char e = p[1];
+        p += 2;
+        if (e != 'u') {
+            if (!std::strchr("\"\\/bfnrt", e) || !e)
+                return NULL;
+            ++length;
+            continue;
+        }
+        unsigned long cp = 0;
+        for (int i = 0; i < 4; ++i) {
+            int v = p + i < end ? hexValue(p[i]) : -1;
+            if (v < 0)
+                return NULL;
+            cp = (cp << 4) | static_cast<unsigned long>(v);
+        }
+        p += 4;
+        if (cp >= 0xDC00 && cp <= 0xDFFF)
+            return NULL;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            // the low half has to follow right away, 4 bytes of utf-8 together
+            unsigned long low = 0;
+            if (end - p < 6 || p[0] != '\\' || p[1] != 'u')
+                return NULL;
+            for (int i = 2; i < 6; ++i) {
+                int v = hexValue(p[i]);
+                if (v < 0)
+                    return NULL;
+                low = (low << 4) | static_cast<unsigned long>(v);
             }
-        } else if (c == '.' && !has_decimal && !has_exponent) {
-            has_decimal = true;
-            value += getChar();
-        } else if ((c == 'e' || c == 'E') && !has_exponent) {
-            has_exponent = true;
-            value += getChar();
-            
-            if (!isAtEndOfLine()) {
-                c = peekChar();
-                if (c == '+' || c == '-') {
-                    value += getChar();
-                }
+            if (low < 0xDC00 || low > 0xDFFF)
+                return NULL;
+            p += 6;
+            length += 4;
+            continue;
+        }
+        length += cp < 0x80 ? 1 : cp < 0x800 ? 2 : 3;
+    }
+}
+
+// ascii goes 8 bytes at a time, the rest one sequence at a time like in strings
+bool TrpJsonLexer::validUtf8( const char* data, size_t len ) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = p + len;
+    while (p < end) {
+        if (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            if (!(word & 0x8080808080808080ULL)) {
+                p += 8;
+                continue;
             }
-        } else {
-            break;
         }
+        if (*p < 0x80) {
+            ++p;
+            continue;
+        }
+        size_t n = utf8SequenceLength(p, end);
+        if (!n)
+            return false;
+        p += n;
     }
-    
-    if (has_decimal && !has_digit_after_decimal) {
-        return createErrorToken("Invalid number format: decimal point must be followed by at least one digit");
+    return true;
+}
+
+static TrpErrorCode numberError( TrpNumberStatus status ) {
+    switch (status) {
+        case NUMBER_MISSING_DIGIT: return ERROR_NUMBER_MISSING_DIGIT;
+        case NUMBER_LEADING_ZERO: return ERROR_NUMBER_LEADING_ZERO;
+        case NUMBER_MISSING_FRACTION_DIGIT: return ERROR_NUMBER_MISSING_FRACTION_DIGIT;
+        default: return ERROR_NUMBER_MISSING_EXPONENT_DIGIT;
     }
-    
-    if (has_exponent && !has_digit_after_exponent) {
-        return createErrorToken("Invalid number format: exponent must be followed by at least one digit");
+}
+
+// grammar check and conversion happen in the same pass, straight on the input bytes.
+// with lazy numbers only the grammar is checked, the value converts the lexeme later
+token TrpJsonLexer::readNumber() {
+    token t;
+    t.type = T_NUMBER;
+    t.line = line;
+    t.col = currentCol() - 1;
+
+    pushBackLexer();
+    const char* start = current;
+    t.offset = start - input_begin;
+    t.error = ERROR_NONE;
+    size_t length;
+    TrpNumberStatus status = lazy_numbers
+        ? TrpJsonNumberParser::scan(start, input_end, length)
+        : TrpJsonNumberParser::parse(start, input_end, t.number, length);
+    current = start + length;
+
+    if (status != NUMBER_OK) {
+        return createErrorToken(numberError(status));
     }
-    
-    t.value = value;
+
+    t.text = start;
+    t.length = length;
     return t;
 }
 
+// the letters are only compared in place, a bad literal is kept as a view for the message
 token TrpJsonLexer::readLiteral() {
-    size_t start_col = col - 1;
-    pushBackLexer();
-    
-    std::string literal;
-    literal += *current;
-    advanceLexer();
-    
-    while (!isAtEndOfLine() && isalpha(peekChar())) {
-        literal += getChar();
-    }
-    
     token t;
     t.line = line;
-    t.col = start_col;
-    
-    if (literal == "true") {
+    t.col = currentCol() - 1;
+    pushBackLexer();
+    const char* start = current;
+    t.offset = start - input_begin;
+    t.error = ERROR_NONE;
+
+    advanceLexer();
+    while (!isAtEnd() && isalpha(peekChar()))
+        advanceLexer();
+    size_t length = current - start;
+
+    if (length == 4 && !std::memcmp(start, "true", 4)) {
         t.type = T_TRUE;
-    } else if (literal == "false") {
+    } else if (length == 5 && !std::memcmp(start, "false", 5)) {
         t.type = T_FALSE;
-    } else if (literal == "null") {
+    } else if (length == 4 && !std::memcmp(start, "null", 4)) {
         t.type = T_NULL;
     } else {
-        std::string error_msg = "Invalid literal: ";
-        error_msg += literal;
-        return createErrorToken(error_msg);
+        return createErrorToken(ERROR_INVALID_LITERAL, start, length);
     }
-    
-    if (t.type != T_ERROR && !isAtEnd()) {
+
+    if (!isAtEnd()) {
         char next = peekChar();
-        if (isalnum(next) || next == '_') {
-            std::string error_msg = "Invalid token: ";
-            error_msg += literal;
-            error_msg += next;
-            return createErrorToken(error_msg);
-        }
+        if (isalnum(next) || next == '_')
+            return createErrorToken(ERROR_INVALID_TOKEN, start, length + 1);
     }
-    
+
     return t;
 }
 
 token TrpJsonLexer::getNextToken() {
-    skipWhitespace();
+    if (use_structural_index)
+        skipToNextStructural();
+    else
+        skipWhitespace();
     
     token t;
     t.line = line;
-    t.col = col;
+    t.col = currentCol();
+    t.offset = current - input_begin;
+    t.error = ERROR_NONE;
     
     if (isAtEnd()) {
         t.type = T_END_OF_FILE;
@@ -294,10 +735,6 @@ token TrpJsonLexer::getNextToken() {
     char c = getChar();
     
     switch (c) {
-        case '\0':
-            t.type = T_END_OF_FILE;
-            break;
-            
         case '{':
             t.type = T_BRACE_OPEN;
             break;
@@ -334,9 +771,7 @@ token TrpJsonLexer::getNextToken() {
             return readLiteral();
             
         default:
-            std::string error_msg = "Unexpected character: ";
-            error_msg += c;
-            return createErrorToken(error_msg);
+            return createErrorToken(ERROR_UNEXPECTED_CHARACTER, current - 1, 1);
     }
     
     return t;
@@ -0,0 +1,324 @@
+#include "../../include/core/TrpJsonNumberFormat.hpp"
+#include <cstring>
+
+// Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers").
+// the double and its two boundaries are scaled by a cached power of ten so the product's
+// integer part fits 32 bits, then digits are cut until what is left lies between the
+// boundaries. everything is 64 bit integer math
+
+#define DOUBLE_SIGNIFICAND_BITS 52
+#define DOUBLE_EXPONENT_BIAS (1023 + DOUBLE_SIGNIFICAND_BITS)
+#define DOUBLE_HIDDEN_BIT (static_cast<uint64_t>(1) << DOUBLE_SIGNIFICAND_BITS)
+// the scaled binary exponent has to land in [GRISU_ALPHA, GRISU_GAMMA]
+#define GRISU_ALPHA -60
+#define GRISU_GAMMA -32
+#define CACHED_POWERS_MIN_EXPONENT -300
+#define CACHED_POWERS_STEP 8
+
+// 10^k rounded to 64 bits, f * 2^e, for k = -300, -292 .. 324.
+// generated once with python big ints
+const TrpJsonNumberFormat::CachedPower TrpJsonNumberFormat::cached_powers[] = {
+    { 0xab70fe17c79ac6caULL, -1060, -300 },
+    { 0xff77b1fcbebcdc4fULL, -1034, -292 },
+    { 0xbe5691ef416bd60cULL, -1007, -284 },
+    { 0x8dd01fad907ffc3cULL,  -980, -276 },
+    { 0xd3515c2831559a83ULL,  -954, -268 },
+    { 0x9d71ac8fada6c9b5ULL,  -927, -260 },
+    { 0xea9c227723ee8bcbULL,  -901, -252 },
+    { 0xaecc49914078536dULL,  -874, -244 },
+    { 0x823c12795db6ce57ULL,  -847, -236 },
+    { 0xc21094364dfb5637ULL,  -821, -228 },
+    { 0x9096ea6f3848984fULL,  -794, -220 },
+    { 0xd77485cb25823ac7ULL,  -768, -212 },
+    { 0xa086cfcd97bf97f4ULL,  -741, -204 },
+    { 0xef340a98172aace5ULL,  -715, -196 },
+    { 0xb23867fb2a35b28eULL,  -688, -188 },
+    { 0x84c8d4dfd2c63f3bULL,  -661, -180 },
+    { 0xc5dd44271ad3cdbaULL,  -635, -172 },
+    { 0x936b9fcebb25c996ULL,  -608, -164 },
+    { 0xdbac6c247d62a584ULL,  -582, -156 },
+    { 0xa3ab66580d5fdaf6ULL,  -555, -148 },
+    { 0xf3e2f893dec3f126ULL,  -529, -140 },
+    { 0xb5b5ada8aaff80b8ULL,  -502, -132 },
+    { 0x87625f056c7c4a8bULL,  -475, -124 },
+    { 0xc9bcff6034c13053ULL,  -449, -116 },
+    { 0x964e858c91ba2655ULL,  -422, -108 },
+    { 0xdff9772470297ebdULL,  -396, -100 },
+    { 0xa6dfbd9fb8e5b88fULL,  -369,  -92 },
+    { 0xf8a95fcf88747d94ULL,  -343,  -84 },
+    { 0xb94470938fa89bcfULL,  -316,  -76 },
+    { 0x8a08f0f8bf0f156bULL,  -289,  -68 },
+    { 0xcdb02555653131b6ULL,  -263,  -60 },
+    { 0x993fe2c6d07b7facULL,  -236,  -52 },
+    { 0xe45c10c42a2b3b06ULL,  -210,  -44 },
+    { 0xaa242499697392d3ULL,  -183,  -36 },
+    { 0xfd87b5f28300ca0eULL,  -157,  -28 },
+    { 0xbce5086492111aebULL,  -130,  -20 },
+    { 0x8cbccc096f5088ccULL,  -103,  -12 },
+    { 0xd1b71758e219652cULL,   -77,   -4 },
+    { 0x9c40000000000000ULL,   -50,    4 },
+    { 0xe8d4a51000000000ULL,   -24,   12 },
+    { 0xad78ebc5ac620000ULL,     3,   20 },
+    { 0x813f3978f8940984ULL,    30,   28 },
+    { 0xc097ce7bc90715b3ULL,    56,   36 },
+    { 0x8f7e32ce7bea5c70ULL,    83,   44 },
+    { 0xd5d238a4abe98068ULL,   109,   52 },
+    { 0x9f4f2726179a2245ULL,   136,   60 },
+    { 0xed63a231d4c4fb27ULL,   162,   68 },
+    { 0xb0de65388cc8ada8ULL,   189,   76 },
+    { 0x83c7088e1aab65dbULL,   216,   84 },
+    { 0xc45d1df942711d9aULL,   242,   92 },
+    { 0x924d692ca61be758ULL,   269,  100 },
+    { 0xda01ee641a708deaULL,   295,  108 },
+    { 0xa26da3999aef774aULL,   322,  116 },
+    { 0xf209787bb47d6b85ULL,   348,  124 },
+    { 0xb454e4a179dd1877ULL,   375,  132 },
+    { 0x865b86925b9bc5c2ULL,   402,  140 },
+    { 0xc83553c5c8965d3dULL,   428,  148 },
+    { 0x952ab45cfa97a0b3ULL,   455,  156 },
+    { 0xde469fbd99a05fe3ULL,   481,  164 },
+    { 0xa59bc234db398c25ULL,   508,  172 },
+    { 0xf6c69a72a3989f5cULL,   534,  180 },
+    { 0xb7dcbf5354e9beceULL,   561,  188 },
+    { 0x88fcf317f22241e2ULL,   588,  196 },
+    { 0xcc20ce9bd35c78a5ULL,   614,  204 },
+    { 0x98165af37b2153dfULL,   641,  212 },
+    { 0xe2a0b5dc971f303aULL,   667,  220 },
+    { 0xa8d9d1535ce3b396ULL,   694,  228 },
+    { 0xfb9b7cd9a4a7443cULL,   720,  236 },
+    { 0xbb764c4ca7a44410ULL,   747,  244 },
+    { 0x8bab8eefb6409c1aULL,   774,  252 },
+    { 0xd01fef10a657842cULL,   800,  260 },
+    { 0x9b10a4e5e9913129ULL,   827,  268 },
+    { 0xe7109bfba19c0c9dULL,   853,  276 },
+    { 0xac2820d9623bf429ULL,   880,  284 },
+    { 0x80444b5e7aa7cf85ULL,   907,  292 },
+    { 0xbf21e44003acdd2dULL,   933,  300 },
+    { 0x8e679c2f5e44ff8fULL,   960,  308 },
+    { 0xd433179d9c8cb841ULL,   986,  316 },
+    { 0x9e19db92b4e31ba9ULL,  1013,  324 },
+};
+
+static const char g_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// f * 2^e
+struct DiyFp
+{
+    uint64_t f;
+    int e;
+
+    DiyFp( uint64_t f_, int e_ ) : f(f_), e(e_) {}
+};
+
+// the high 64 bits of the product, rounded
+static inline DiyFp multiply( const DiyFp& x, const DiyFp& y ) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = static_cast<unsigned __int128>(x.f) * y.f;
+    uint64_t high = static_cast<uint64_t>(r >> 64) + static_cast<uint64_t>((r >> 63) & 1);
+#else
+    uint64_t x_lo = x.f & 0xFFFFFFFFULL, x_hi = x.f >> 32;
+    uint64_t y_lo = y.f & 0xFFFFFFFFULL, y_hi = y.f >> 32;
+    uint64_t lo_lo = x_lo * y_lo, hi_lo = x_hi * y_lo, lo_hi = x_lo * y_hi, hi_hi = x_hi * y_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + (lo_hi & 0xFFFFFFFFULL);
+    cross += 1ULL << 31;
+    uint64_t high = hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (cross >> 32);
+#endif
+    return DiyFp( high, x.e + y.e + 64 );
+}
+
+static inline DiyFp normalize( DiyFp x ) {
+    while ( !(x.f >> 63) ) {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+// the number of decimal digits of n and the power of ten of the first one
+static inline int largestPow10( uint32_t n, uint32_t& pow10 ) {
+    static const uint32_t powers[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    int k = 10;
+    while ( k > 1 && n < powers[k - 1] )
+        --k;
+    pow10 = powers[k - 1];
+    return k;
+}
+
+// moves the last digit down while that gets closer to the value and stays inside the boundaries
+static inline void grisuRound( char* digits, int length, uint64_t dist, uint64_t delta,
+                               uint64_t rest, uint64_t ten_k ) {
+    while ( rest < dist && delta - rest >= ten_k
+            && (rest + ten_k < dist || dist - rest > rest + ten_k - dist) ) {
+        --digits[length - 1];
+        rest += ten_k;
+    }
+}
+
+// value > 0 and finite. digits * 10^exponent is the shortest we found
+void TrpJsonNumberFormat::grisu2( double value, char* digits, int& length, int& exponent ) {
+    uint64_t bits;
+    std::memcpy( &bits, &value, sizeof(bits) );
+    uint64_t F = bits & (DOUBLE_HIDDEN_BIT - 1);
+    int E = static_cast<int>(bits >> DOUBLE_SIGNIFICAND_BITS);
+
+    // the boundaries are half way to the neighbours, the lower one is closer at a power of two
+    DiyFp v = E ? DiyFp( F + DOUBLE_HIDDEN_BIT, E - DOUBLE_EXPONENT_BIAS ) : DiyFp( F, 1 - DOUBLE_EXPONENT_BIAS );
+    bool lower_closer = F == 0 && E > 1;
+    DiyFp m_plus = normalize( DiyFp( 2 * v.f + 1, v.e - 1 ) );
+    DiyFp m_minus = lower_closer ? DiyFp( 4 * v.f - 1, v.e - 2 ) : DiyFp( 2 * v.f - 1, v.e - 1 );
+    m_minus.f <<= m_minus.e - m_plus.e;
+    m_minus.e = m_plus.e;
+    v = normalize( v );
+
+    // the cached 10^-k that brings m_plus' exponent into [alpha, gamma]
+    int f = GRISU_ALPHA - m_plus.e - 1;
+    int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+    const CachedPower& cached = cached_powers[(-CACHED_POWERS_MIN_EXPONENT + k + (CACHED_POWERS_STEP - 1)) / CACHED_POWERS_STEP];
+    DiyFp c( cached.f, cached.e );
+
+    DiyFp w = multiply( v, c );
+    DiyFp low = multiply( m_minus, c );
+    DiyFp high = multiply( m_plus, c );
+    // one unit in from both ends covers the rounding of the multiplications
+    ++low.f;
+    --high.f;
+    exponent = -cached.k;
+
+    uint64_t delta = high.f - low.f;
+    uint64_t dist = high.f - w.f;
+    int shift = -high.e;
+    uint64_t one = static_cast<uint64_t>(1) << shift;
+    uint32_t p1 = static_cast<uint32_t>(high.f >> shift);
+    uint64_t p2 = high.f & (one - 1);
+
+    // integral part first, we may be done before its last digit
+    uint32_t pow10;
+    int n = largestPow10( p1, pow10 );
+    length = 0;
+    while ( n > 0 ) {
+        digits[length++] = static_cast<char>('0' + p1 / pow10);
+        p1 %= pow10;
+        --n;
+        uint64_t rest = (static_cast<uint64_t>(p1) << shift) + p2;
+        if ( rest <= delta ) {
+            exponent += n;
+            grisuRound( digits, length, dist, delta, rest, static_cast<uint64_t>(pow10) << shift );
+            return;
+        }
+        pow10 /= 10;
+    }
+
+    // then the fraction, delta and dist grow with every digit
+    while ( true ) {
+        p2 *= 10;
+        digits[length++] = static_cast<char>('0' + (p2 >> shift));
+        p2 &= one - 1;
+        delta *= 10;
+        dist *= 10;
+        --exponent;
+        if ( p2 <= delta ) break;
+    }
+    grisuRound( digits, length, dist, delta, p2, one );
+}
+
+// digits * 10^exponent the way JavaScript prints it: plain up to 21 integer digits, 0.000001
+// at the small end, scientific with a signed exponent past that
+size_t TrpJsonNumberFormat::layout( char* out, const char* digits, int length, int exponent ) {
+    while ( length > 1 && digits[length - 1] == '0' ) {
+        --length;
+        ++exponent;
+    }
+    int point = length + exponent;
+    char* p = out;
+
+    if ( length <= point && point <= 21 ) {
+        std::memcpy( p, digits, length );
+        p += length;
+        std::memset( p, '0', point - length );
+        return p + (point - length) - out;
+    }
+    if ( 0 < point && point <= 21 ) {
+        std::memcpy( p, digits, point );
+        p += point;
+        *p++ = '.';
+        std::memcpy( p, digits + point, length - point );
+        return p + (length - point) - out;
+    }
+    if ( -6 < point && point <= 0 ) {
+        *p++ = '0';
+        *p++ = '.';
+        std::memset( p, '0', -point );
+        p += -point;
+        std::memcpy( p, digits, length );
+        return p + length - out;
+    }
+
+    *p++ = digits[0];
+    if ( length > 1 ) {
+        *p++ = '.';
+        std::memcpy( p, digits + 1, length - 1 );
+        p += length - 1;
+    }
+    *p++ = 'e';
+    int e = point - 1;
+    *p++ = e < 0 ? '-' : '+';
+    return p + formatUint64( static_cast<uint64_t>(e < 0 ? -e : e), p ) - out;
+}
+
+size_t TrpJsonNumberFormat::formatDouble( double value, char* out ) {
+    if ( value != value || value - value != 0 ) {
+        std::memcpy( out, "null", 4 );
+        return 4;
+    }
+
+    char* p = out;
+    // -0 keeps its sign, it reads back as -0
+    uint64_t bits;
+    std::memcpy( &bits, &value, sizeof(bits) );
+    if ( bits >> 63 ) {
+        *p++ = '-';
+        value = -value;
+    }
+    // integers are exact below 2^53, no digits to search for
+    if ( value < 9007199254740992.0 && value == static_cast<double>(static_cast<uint64_t>(value)) )
+        return p - out + formatUint64( static_cast<uint64_t>(value), p );
+
+    char digits[20];
+    int length, exponent;
+    grisu2( value, digits, length, exponent );
+    return p - out + layout( p, digits, length, exponent );
+}
+
+size_t TrpJsonNumberFormat::formatInt64( int64_t value, char* out ) {
+    if ( value >= 0 )
+        return formatUint64( static_cast<uint64_t>(value), out );
+    *out = '-';
+    return 1 + formatUint64( 0 - static_cast<uint64_t>(value), out + 1 );
+}
+
+// two digits per division, right to left into a scratch buffer
+size_t TrpJsonNumberFormat::formatUint64( uint64_t value, char* out ) {
+    char scratch[20];
+    char* end = scratch + sizeof(scratch);
+    char* p = end;
+    while ( value >= 100 ) {
+        const char* pair = g_digit_pairs + (value % 100) * 2;
+        value /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if ( value >= 10 ) {
+        const char* pair = g_digit_pairs + value * 2;
+        *--p = pair[1];
+        *--p = pair[0];
+    } else {
+        *--p = static_cast<char>('0' + value);
+    }
+    std::memcpy( out, p, end - p );
+    return end - p;
+}
@@ -0,0 +1,348 @@
+#include "../../include/core/TrpJsonNumberParser.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <clocale>
+#include <string>
+
+// 10^0 .. 10^22 are exact doubles, that is what makes Clinger's fast path exact
+static const double g_exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define SMALLEST_POWER_OF_TEN -342
+#define LARGEST_POWER_OF_TEN 308
+#define MANTISSA_EXPLICIT_BITS 52
+#define MINIMUM_EXPONENT -1023
+#define INFINITE_POWER 0x7FF
+
+static inline bool isDigit( char c ) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+static inline void multiply128( uint64_t a, uint64_t b, uint64_t& high, uint64_t& low ) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(r >> 64);
+    low = static_cast<uint64_t>(r);
+#else
+    uint64_t a_lo = a & 0xFFFFFFFFULL, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFFULL, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + lo_hi;
+    high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    low = (cross << 32) | (lo_lo & 0xFFFFFFFFULL);
+#endif
+}
+
+static inline double assembleDouble( uint64_t mantissa, int32_t power2, bool negative ) {
+    uint64_t bits = mantissa | (static_cast<uint64_t>(power2) << MANTISSA_EXPLICIT_BITS);
+    if (negative)
+        bits |= static_cast<uint64_t>(1) << 63;
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+const char* TrpJsonNumberParser::statusMessage( TrpNumberStatus status ) {
+    switch (status) {
+        case NUMBER_MISSING_DIGIT:
+            return "Invalid number format: minus sign must be followed by a digit";
+        case NUMBER_LEADING_ZERO:
+            return "Invalid number format: leading zeros are not allowed";
+        case NUMBER_MISSING_FRACTION_DIGIT:
+            return "Invalid number format: decimal point must be followed by at least one digit";
+        case NUMBER_MISSING_EXPONENT_DIGIT:
+            return "Invalid number format: exponent must be followed by at least one digit";
+        default:
+            return "";
+    }
+}
+
+// w * 10^q is exact when both w and 10^|q| are exact doubles, one rounding gives the right answer
+bool TrpJsonNumberParser::clingerFastPath( uint64_t w, int64_t q, bool negative, double& out ) {
+#if defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ != 0
+    // x87 extended precision would round twice
+    (void)w; (void)q; (void)negative; (void)out;
+    return false;
+#else
+    if (q < -22 || q > 22 || w > (static_cast<uint64_t>(1) << 53))
+        return false;
+    double d = static_cast<double>(w);
+    if (q < 0)
+        d /= g_exact_powers_of_ten[-q];
+    else
+        d *= g_exact_powers_of_ten[q];
+    out = negative ? -d : d;
+    return true;
+#endif
+}
+
+// Eisel-Lemire: multiply the normalized mantissa by a 128 bit truncated 5^q and keep the
+// top bits. the second product only matters when the first one can't decide the rounding
+void TrpJsonNumberParser::eiselLemire( uint64_t w, int64_t q, uint64_t& mantissa, int32_t& power2 ) {
+    if (w == 0 || q < SMALLEST_POWER_OF_TEN) {
+        mantissa = 0;
+        power2 = 0;
+        return;
+    }
+    if (q > LARGEST_POWER_OF_TEN) {
+        mantissa = 0;
+        power2 = INFINITE_POWER;
+        return;
+    }
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    size_t index = 2 * static_cast<size_t>(q - SMALLEST_POWER_OF_TEN);
+    uint64_t high, low;
+    multiply128(w, power_of_five_128[index], high, low);
+
+    const uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFULL >> (MANTISSA_EXPLICIT_BITS + 3);
+    if ((high & precision_mask) == precision_mask) {
+        uint64_t second_high, second_low;
+        multiply128(w, power_of_five_128[index + 1], second_high, second_low);
+        low += second_high;
+        if (second_high > low)
+            ++high;
+    }
+
+    int upperbit = static_cast<int>(high >> 63);
+    int shift = upperbit + 64 - MANTISSA_EXPLICIT_BITS - 3;
+    mantissa = high >> shift;
+    // floor(q * log2(10)) + 63, the 152170 + 65536 constant is log2(10) in 16.16
+    int32_t power_of_q = static_cast<int32_t>((((152170 + 65536) * q) >> 16) + 63);
+    power2 = power_of_q + upperbit - lz - MINIMUM_EXPONENT;
+
+    if (power2 <= 0) {
+        // subnormal
+        if (-power2 + 1 >= 64) {
+            mantissa = 0;
+            power2 = 0;
+            return;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += (mantissa & 1);
+        mantissa >>= 1;
+        power2 = (mantissa < (static_cast<uint64_t>(1) << MANTISSA_EXPLICIT_BITS)) ? 0 : 1;
+        return;
+    }
+
+    // exactly halfway between two doubles can only happen for small q, round to even there
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1) {
+        if ((mantissa << shift) == high)
+            mantissa &= ~static_cast<uint64_t>(1);
+    }
+
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    if (mantissa >= (static_cast<uint64_t>(2) << MANTISSA_EXPLICIT_BITS)) {
+        mantissa = static_cast<uint64_t>(1) << MANTISSA_EXPLICIT_BITS;
+        ++power2;
+    }
+    mantissa &= ~(static_cast<uint64_t>(1) << MANTISSA_EXPLICIT_BITS);
+    if (power2 >= INFINITE_POWER) {
+        power2 = INFINITE_POWER;
+        mantissa = 0;
+    }
+}
+
+// only for mantissas longer than 19 digits sitting right on a rounding boundary.
+// strtod wants the locale decimal point so swap it in
+double TrpJsonNumberParser::slowPath( const char* start, size_t len ) {
+    std::string text(start, len);
+    const char* point = std::localeconv()->decimal_point;
+    if (point && point[0] != '.') {
+        size_t dot = text.find('.');
+        if (dot != std::string::npos)
+            text.replace(dot, 1, point);
+    }
+    return std::strtod(text.c_str(), NULL);
+}
+
+TrpNumberStatus TrpJsonNumberParser::scan( const char* p, const char* end, size_t& length ) {
+    const char* start = p;
+
+    if (p != end && *p == '-')
+        ++p;
+    if (p == end || !isDigit(*p)) {
+        length = p - start;
+        return NUMBER_MISSING_DIGIT;
+    }
+    if (*p == '0') {
+        ++p;
+        if (p != end && isDigit(*p)) {
+            length = p - start;
+            return NUMBER_LEADING_ZERO;
+        }
+    } else {
+        while (p != end && isDigit(*p))
+            ++p;
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        if (p == end || !isDigit(*p)) {
+            length = p - start;
+            return NUMBER_MISSING_FRACTION_DIGIT;
+        }
+        while (p != end && isDigit(*p))
+            ++p;
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p != end && (*p == '+' || *p == '-'))
+            ++p;
+        if (p == end || !isDigit(*p)) {
+            length = p - start;
+            return NUMBER_MISSING_EXPONENT_DIGIT;
+        }
+        while (p != end && isDigit(*p))
+            ++p;
+    }
+    length = p - start;
+    return NUMBER_OK;
+}
+
+TrpNumberStatus TrpJsonNumberParser::parse( const char* p, const char* end, TrpNumber& out, size_t& length ) {
+    const char* start = p;
+
+    out.value = 0;
+    out.negative = false;
+    out.is_integer = false;
+    out.magnitude = 0;
+
+    if (p != end && *p == '-') {
+        out.negative = true;
+        ++p;
+    }
+    if (p == end || !isDigit(*p)) {
+        length = p - start;
+        return NUMBER_MISSING_DIGIT;
+    }
+
+    // digits are accumulated blindly, wrapping is sorted out once we know how many there were
+    uint64_t w = 0;
+    const char* int_start = p;
+    if (*p == '0') {
+        ++p;
+        if (p != end && isDigit(*p)) {
+            length = p - start;
+            return NUMBER_LEADING_ZERO;
+        }
+    } else {
+        while (p != end && isDigit(*p)) {
+            w = w * 10 + static_cast<uint64_t>(*p - '0');
+            ++p;
+        }
+    }
+    const char* int_end = p;
+
+    const char* frac_start = p;
+    const char* frac_end = p;
+    bool has_fraction = false;
+    if (p != end && *p == '.') {
+        ++p;
+        frac_start = p;
+        while (p != end && isDigit(*p)) {
+            w = w * 10 + static_cast<uint64_t>(*p - '0');
+            ++p;
+        }
+        if (p == frac_start) {
+            length = p - start;
+            return NUMBER_MISSING_FRACTION_DIGIT;
+        }
+        frac_end = p;
+        has_fraction = true;
+    }
+
+    int64_t explicit_exponent = 0;
+    bool has_exponent = false;
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool exponent_negative = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            exponent_negative = (*p == '-');
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) {
+            length = p - start;
+            return NUMBER_MISSING_EXPONENT_DIGIT;
+        }
+        while (p != end && isDigit(*p)) {
+            // anything past this is 0 or infinity anyway
+            if (explicit_exponent < 0x10000000)
+                explicit_exponent = explicit_exponent * 10 + (*p - '0');
+            ++p;
+        }
+        if (exponent_negative)
+            explicit_exponent = -explicit_exponent;
+        has_exponent = true;
+    }
+    length = p - start;
+
+    size_t int_digits = int_end - int_start;
+    size_t frac_digits = frac_end - frac_start;
+
+    // integer fast path, exact up to 2^64 - 1. -0 stays a double so the sign survives
+    if (!has_fraction && !has_exponent && !(out.negative && w == 0)) {
+        if (int_digits < 20 || (int_digits == 20 && std::memcmp(int_start, "18446744073709551615", 20) <= 0)) {
+            out.is_integer = true;
+            out.magnitude = w;
+            out.value = out.negative ? -static_cast<double>(w) : static_cast<double>(w);
+            return NUMBER_OK;
+        }
+    }
+
+    int64_t exponent = explicit_exponent - static_cast<int64_t>(frac_digits);
+
+    // leading zeros (0.000123) are not significant
+    size_t digit_count = int_digits + frac_digits;
+    if (digit_count > 19 && *int_start == '0') {
+        --digit_count;
+        for (const char* f = frac_start; f != frac_end && *f == '0'; ++f)
+            --digit_count;
+    }
+
+    // more than 19 significant digits: keep the first 19, the rest only moves the exponent
+    bool truncated = false;
+    if (digit_count > 19) {
+        const uint64_t minimal_nineteen_digit_integer = 1000000000000000000ULL;
+        const char* d = int_start;
+        truncated = true;
+        w = 0;
+        while (w < minimal_nineteen_digit_integer && d != int_end) {
+            w = w * 10 + static_cast<uint64_t>(*d - '0');
+            ++d;
+        }
+        if (w >= minimal_nineteen_digit_integer) {
+            exponent = (int_end - d) + explicit_exponent;
+        } else {
+            d = frac_start;
+            while (w < minimal_nineteen_digit_integer && d != frac_end) {
+                w = w * 10 + static_cast<uint64_t>(*d - '0');
+                ++d;
+            }
+            exponent = (frac_start - d) + explicit_exponent;
+        }
+    }
+
+    if (!truncated && clingerFastPath(w, exponent, out.negative, out.value))
+        return NUMBER_OK;
+
+    uint64_t mantissa;
+    int32_t power2;
+    eiselLemire(w, exponent, mantissa, power2);
+    if (truncated) {
+        // the dropped digits put the real value between w and w + 1, both have to agree
+        uint64_t mantissa_up;
+        int32_t power2_up;
+        eiselLemire(w + 1, exponent, mantissa_up, power2_up);
+        if (mantissa != mantissa_up || power2 != power2_up) {
+            out.value = slowPath(start, length);
+            return NUMBER_OK;
+        }
+    }
+    out.value = assembleDouble(mantissa, power2, out.negative);
+    return NUMBER_OK;
+}
@@ -0,0 +1,250 @@
+#include "../../include/core/TrpJsonSimd.hpp"
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# define TRP_SIMD_X86 1
+# include <immintrin.h>
+#endif
+
+typedef void (*TrpClassifyFn)( const char* block, TrpBlockMasks& masks );
+typedef size_t (*TrpStringScanFn)( const char* data, size_t len );
+
+// scalar fallback, a table keeps it branch free enough
+
+enum {
+    CLASS_QUOTE = 1,
+    CLASS_BACKSLASH = 2,
+    CLASS_OP = 4,
+    CLASS_WHITESPACE = 8
+};
+
+static unsigned char g_class_table[256];
+
+static void buildClassTable( void ) {
+    for (int i = 0; i < 256; ++i)
+        g_class_table[i] = 0;
+    g_class_table[static_cast<unsigned char>('"')] = CLASS_QUOTE;
+    g_class_table[static_cast<unsigned char>('\\')] = CLASS_BACKSLASH;
+    g_class_table[static_cast<unsigned char>('{')] = CLASS_OP;
+    g_class_table[static_cast<unsigned char>('}')] = CLASS_OP;
+    g_class_table[static_cast<unsigned char>('[')] = CLASS_OP;
+    g_class_table[static_cast<unsigned char>(']')] = CLASS_OP;
+    g_class_table[static_cast<unsigned char>(':')] = CLASS_OP;
+    g_class_table[static_cast<unsigned char>(',')] = CLASS_OP;
+    g_class_table[static_cast<unsigned char>(' ')] = CLASS_WHITESPACE;
+    g_class_table[static_cast<unsigned char>('\t')] = CLASS_WHITESPACE;
+    g_class_table[static_cast<unsigned char>('\n')] = CLASS_WHITESPACE;
+    g_class_table[static_cast<unsigned char>('\r')] = CLASS_WHITESPACE;
+}
+
+static void classifyScalar( const char* block, TrpBlockMasks& masks ) {
+    masks.quote = masks.backslash = masks.op = masks.whitespace = 0;
+    for (int i = 0; i < TRP_SIMD_BLOCK_SIZE; ++i) {
+        unsigned char cls = g_class_table[static_cast<unsigned char>(block[i])];
+        uint64_t bit = static_cast<uint64_t>(1) << i;
+        if (cls & CLASS_QUOTE) masks.quote |= bit;
+        if (cls & CLASS_BACKSLASH) masks.backslash |= bit;
+        if (cls & CLASS_OP) masks.op |= bit;
+        if (cls & CLASS_WHITESPACE) masks.whitespace |= bit;
+    }
+}
+
+static size_t findStringSpecialScalar( const char* data, size_t len ) {
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80)
+            return i;
+    }
+    return len;
+}
+
+#ifdef TRP_SIMD_X86
+
+// '[' and '{' (and ']' and '}') only differ by 0x20 so one compare covers both
+
+__attribute__((target("sse2")))
+static void classifySse2( const char* block, TrpBlockMasks& masks ) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i brace_open = _mm_set1_epi8('{');
+    const __m128i brace_close = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+
+    masks.quote = masks.backslash = masks.op = masks.whitespace = 0;
+    for (int i = 0; i < TRP_SIMD_BLOCK_SIZE; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        __m128i folded = _mm_or_si128(v, case_bit);
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, brace_open), _mm_cmpeq_epi8(folded, brace_close)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage)));
+
+        masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << i;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << i;
+        masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << i;
+        masks.whitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ws))) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+static void classifyAvx2( const char* block, TrpBlockMasks& masks ) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i brace_open = _mm256_set1_epi8('{');
+    const __m256i brace_close = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+
+    masks.quote = masks.backslash = masks.op = masks.whitespace = 0;
+    for (int i = 0; i < TRP_SIMD_BLOCK_SIZE; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        __m256i folded = _mm256_or_si256(v, case_bit);
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, brace_open), _mm256_cmpeq_epi8(folded, brace_close)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, carriage)));
+
+        masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << i;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << i;
+        masks.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << i;
+        masks.whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << i;
+    }
+}
+
+// a signed compare against 0x20 catches control characters and every byte >= 0x80 at once
+
+__attribute__((target("sse2")))
+static size_t findStringSpecialSse2( const char* data, size_t len ) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x20);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmplt_epi8(v, control));
+        int mask = _mm_movemask_epi8(special);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + findStringSpecialScalar(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t findStringSpecialAvx2( const char* data, size_t len ) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        // no signed less than in avx2, 0x20 > v is the same thing
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpgt_epi8(control, v));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    // gcc leaves the upper halves dirty around this call, every sse instruction after it
+    // (memcpy included) would then pay for the transition. short strings always get here
+    _mm256_zeroupper();
+    return i + findStringSpecialSse2(data + i, len - i);
+}
+
+#endif // TRP_SIMD_X86
+
+// dispatch state, filled once by the first caller on any thread (pthread_once makes the
+// others wait and see every store). only setLevel() writes it after that
+
+static pthread_once_t g_detect_once = PTHREAD_ONCE_INIT;
+static TrpSimdLevel g_detected_level = TRP_SIMD_SCALAR;
+static TrpSimdLevel g_level = TRP_SIMD_SCALAR;
+static TrpClassifyFn g_classify = NULL;
+static TrpStringScanFn g_string_scan = NULL;
+
+static void selectKernels( TrpSimdLevel level ) {
+    switch (level) {
+#ifdef TRP_SIMD_X86
+        case TRP_SIMD_AVX2:
+            g_classify = classifyAvx2;
+            g_string_scan = findStringSpecialAvx2;
+            break;
+        case TRP_SIMD_SSE2:
+            g_classify = classifySse2;
+            g_string_scan = findStringSpecialSse2;
+            break;
+#endif
+        default:
+            level = TRP_SIMD_SCALAR;
+            g_classify = classifyScalar;
+            g_string_scan = findStringSpecialScalar;
+            break;
+    }
+    g_level = level;
+}
+
+static void detectOnce( void ) {
+    TrpSimdLevel level = TRP_SIMD_SCALAR;
+#ifdef TRP_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        level = TRP_SIMD_AVX2;
+    else if (__builtin_cpu_supports("sse2"))
+        level = TRP_SIMD_SSE2;
+#endif
+    buildClassTable();
+    g_detected_level = level;
+    selectKernels(level);
+}
+
+TrpSimdLevel TrpJsonSimd::detect( void ) {
+    pthread_once(&g_detect_once, detectOnce);
+    return g_detected_level;
+}
+
+TrpSimdLevel TrpJsonSimd::level( void ) {
+    detect();
+    return g_level;
+}
+
+void TrpJsonSimd::setLevel( TrpSimdLevel level ) {
+    TrpSimdLevel best = detect();
+    selectKernels(level > best ? best : level);
+}
+
+const char* TrpJsonSimd::levelName( TrpSimdLevel level ) {
+    switch (level) {
+        case TRP_SIMD_AVX2: return "avx2";
+        case TRP_SIMD_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+void TrpJsonSimd::classifyBlock( const char* block, TrpBlockMasks& masks ) {
+    pthread_once(&g_detect_once, detectOnce);
+    g_classify(block, masks);
+}
+
+size_t TrpJsonSimd::findStringSpecial( const char* data, size_t len ) {
+    pthread_once(&g_detect_once, detectOnce);
+    return g_string_scan(data, len);
+}
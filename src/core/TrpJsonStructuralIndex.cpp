@@ -0,0 +1,136 @@
+#include "../../include/core/TrpJsonStructuralIndex.hpp"
+#include "../../include/core/TrpJsonSimd.hpp"
+#include <cstring>
+
+TrpJsonStructuralIndex::TrpJsonStructuralIndex( void ) {}
+
+TrpJsonStructuralIndex::~TrpJsonStructuralIndex( void ) {}
+
+void TrpJsonStructuralIndex::clear( void ) {
+    positions.clear();
+}
+
+size_t TrpJsonStructuralIndex::size( void ) const {
+    return positions.size();
+}
+
+size_t TrpJsonStructuralIndex::operator[]( size_t i ) const {
+    return positions[i];
+}
+
+// bit i of the result is the xor of bits 0..i, turns quote bits into "inside string" bits
+uint64_t TrpJsonStructuralIndex::prefixXor( uint64_t bits ) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// marks every byte preceded by an odd run of backslashes, the run can start in the previous block
+uint64_t TrpJsonStructuralIndex::findEscaped( uint64_t backslash, uint64_t& prev_escaped ) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+
+    if (!backslash) {
+        uint64_t escaped = prev_escaped;
+        prev_escaped = 0;
+        return escaped;
+    }
+    backslash &= ~prev_escaped;
+    uint64_t follows_escape = (backslash << 1) | prev_escaped;
+    uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+
+    // adding the starts carries through each run, where the carry lands tells the run parity
+    uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    prev_escaped = sequences_starting_on_even_bits < backslash ? 1 : 0;
+
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+void TrpJsonStructuralIndex::build( const char* data, size_t len ) {
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;
+    uint64_t prev_scalar = 0;
+    char tail[TRP_SIMD_BLOCK_SIZE];
+    TrpBlockMasks masks;
+
+    // written through a raw pointer, the vector only grows (doubling) and is trimmed at the end
+    size_t count = 0;
+    positions.resize(len / 8 + TRP_SIMD_BLOCK_SIZE);
+    for (size_t base = 0; base < len; base += TRP_SIMD_BLOCK_SIZE) {
+        const char* block = data + base;
+        if (len - base < TRP_SIMD_BLOCK_SIZE) {
+            // pad the last block with spaces, they never show up in the index
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, len - base);
+            block = tail;
+        }
+        TrpJsonSimd::classifyBlock(block, masks);
+
+        uint64_t escaped = findEscaped(masks.backslash, prev_escaped);
+        uint64_t quote = masks.quote & ~escaped;
+
+        // opening quote and string body are set, the closing quote is not
+        uint64_t in_string = prefixXor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        uint64_t scalar = ~(masks.op | masks.whitespace | quote) & ~in_string;
+        uint64_t follows_scalar = (scalar << 1) | prev_scalar;
+        prev_scalar = scalar >> 63;
+
+        uint64_t structurals = (masks.op & ~in_string) | (quote & in_string) | (scalar & ~follows_scalar);
+        if (!structurals)
+            continue;
+
+        if (positions.size() - count < TRP_SIMD_BLOCK_SIZE)
+            positions.resize(positions.size() * 2);
+        size_t* out = &positions[count];
+        count += __builtin_popcountll(structurals);
+        while (structurals) {
+            *out++ = base + __builtin_ctzll(structurals);
+            structurals &= structurals - 1;
+        }
+    }
+    positions.resize(count);
+}
+
+const char* TrpJsonStructuralIndex::findLevelEnd( const char* p, const char* end, const char* cut_from ) {
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;
+    char tail[TRP_SIMD_BLOCK_SIZE];
+    TrpBlockMasks masks;
+    size_t depth = 0;
+
+    for (; p < end; p += TRP_SIMD_BLOCK_SIZE) {
+        const char* block = p;
+        if (static_cast<size_t>(end - p) < TRP_SIMD_BLOCK_SIZE) {
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, p, end - p);
+            block = tail;
+        }
+        TrpJsonSimd::classifyBlock(block, masks);
+        uint64_t escaped = findEscaped(masks.backslash, prev_escaped);
+        uint64_t in_string = prefixXor(masks.quote & ~escaped) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        // only the ops outside strings, : falls through
+        uint64_t ops = masks.op & ~in_string;
+        while (ops) {
+            size_t i = __builtin_ctzll(ops);
+            ops &= ops - 1;
+            char c = block[i];
+            if (c == '[' || c == '{') {
+                ++depth;
+            } else if (c == ']' || c == '}') {
+                if (depth-- == 0)
+                    return p + i;
+            } else if (c == ',' && depth == 0 && p + i >= cut_from) {
+                return p + i;
+            }
+        }
+    }
+    return NULL;
+}
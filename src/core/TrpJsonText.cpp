@@ -0,0 +1,48 @@
+#include "../../include/core/TrpJsonText.hpp"
+#include <cstring>
+
+TrpJsonText::TrpJsonText( void ) : m_size(0), m_owned(false) {
+    m_inline[0] = '\0';
+}
+
+TrpJsonText::TrpJsonText( const char* data, size_t len, TrpJsonArena* arena, TrpJsonInternPool* pool )
+    : m_size(len), m_owned(false) {
+    if (len < TRP_TEXT_INLINE_SIZE) {
+        std::memcpy(m_inline, data, len);
+        m_inline[len] = '\0';
+        return;
+    }
+    if (pool && (m_ptr = pool->intern(data, len)))
+        return;
+
+    char* copy;
+    if (arena) {
+        copy = static_cast<char*>(arena->allocate(len + 1));
+    } else {
+        copy = new char[len + 1];
+        m_owned = true;
+    }
+    std::memcpy(copy, data, len);
+    copy[len] = '\0';
+    m_ptr = copy;
+}
+
+void TrpJsonText::release( void ) {
+    if (m_owned)
+        delete[] m_ptr;
+    m_owned = false;
+    m_size = 0;
+    m_inline[0] = '\0';
+}
+
+bool TrpJsonText::equals( const char* data, size_t len ) const {
+    return m_size == len && std::memcmp(this->data(), data, len) == 0;
+}
+
+std::string TrpJsonText::str( void ) const {
+    return std::string(data(), m_size);
+}
+
+std::ostream& operator<<( std::ostream& os, const TrpJsonText& text ) {
+    return os.write(text.data(), text.size());
+}
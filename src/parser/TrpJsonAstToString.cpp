@@ -4,9 +4,12 @@
 #include "../../include/values/TrpJsonString.hpp"
 #include "../../include/values/TrpJsonNumber.hpp"
 #include "../../include/values/TrpJsonBool.hpp"
+#include "../../include/core/TrpJsonNumberFormat.hpp"
+#include "../../include/parser/TrpJsonWriter.hpp"
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <cstdio>
 
 std::string createTabIndent(int level) {
     return std::string(level, '\t');
@@ -22,7 +25,7 @@ std::string astObjectToString(TrpJsonObject* obj, int indentLevel) {
     oss << BRACE_COLOR << "{" << RESET << "\n";
     
     size_t count = 0;
-    for (JsonObjectMap::const_iterator it = obj->begin(); it != obj->end(); ++it) {
+    for (JsonObjectVector::const_iterator it = obj->begin(); it != obj->end(); ++it) {
         oss << nextIndent 
             << KEY_COLOR << "\"" << it->first << "\"" << RESET 
             << PUNCT_COLOR << ": " << RESET 
@@ -71,9 +74,20 @@ std::string astValueToString(ITrpJsonValue* value, int indentLevel) {
         
         case TRP_NUMBER: {
             TrpJsonNumber* num = static_cast<TrpJsonNumber*>(value);
-            std::ostringstream oss;
-            oss << NUMBER_COLOR << num->getValue() << RESET;
-            return oss.str();
+            // raw numbers go out as they came in, integers stay exact, doubles round-trip
+            if (num->isRaw())
+                return NUMBER_COLOR + num->getRaw() + RESET;
+            char digits[TRP_NUMBER_FORMAT_BYTES];
+            size_t len;
+            int64_t i;
+            uint64_t u;
+            if (num->getInt64(i))
+                len = TrpJsonNumberFormat::formatInt64(i, digits);
+            else if (num->getUint64(u))
+                len = TrpJsonNumberFormat::formatUint64(u, digits);
+            else
+                len = TrpJsonNumberFormat::formatDouble(num->getValue(), digits);
+            return NUMBER_COLOR + std::string(digits, len) + RESET;
         }
         
         case TRP_BOOL: {
@@ -108,6 +122,14 @@ std::string TrpJsonParser::astToString(void) const {
     return astValueToString(head, 0);
 }
 
+// streamed to stdout, nothing is built first. colors only on a terminal
 void TrpJsonParser::prettyPrint() const {
-    std::cout << astToString() << std::endl;
+    std::cout.flush();
+    TrpJsonWriter writer(stdout);
+    writer.setIndent(1, '\t');
+    writer.setColors(WRITER_COLORS_AUTO);
+    writer.write(parsed ? head : NULL);
+    writer.flush();
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
 }
\ No newline at end of file
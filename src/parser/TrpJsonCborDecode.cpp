@@ -0,0 +1,125 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+
+// CBOR straight into the tree. the walk is TrpJsonCbor::read()'s and every item is checked
+// the same way, the stack frames count the items (pairs for a map) each container still has
+// and nodes are hooked to their parent as soon as they exist, like in parseValue()
+
+bool TrpJsonParser::failCbor( const unsigned char* begin, const unsigned char* at, TrpErrorCode code ) {
+    token t;
+    t.type = T_ERROR;
+    t.line = t.col = 0;
+    t.offset = at - begin;
+    t.error = code;
+    t.text = NULL;
+    t.length = 0;
+    fail( t, 0 );
+    return false;
+}
+
+// a scalar, or the still empty array / object
+ITrpJsonValue* TrpJsonParser::cborValue( const TrpCborHead& item ) {
+    TrpJsonArena* node_arena = nodeArena();
+    switch ( item.major ) {
+        case TRP_CBOR_UNSIGNED: case TRP_CBOR_NEGATIVE: {
+            // -1 - argument, so the magnitude is one more. only -2^64 doesn't fit
+            TrpNumber number;
+            number.value = TrpJsonCbor::toDouble( item );
+            number.negative = item.major == TRP_CBOR_NEGATIVE;
+            number.magnitude = number.negative ? item.argument + 1 : item.argument;
+            number.is_integer = !number.negative || number.magnitude != 0;
+            return node_arena ? new (*node_arena) TrpJsonNumber(number) : new TrpJsonNumber(number);
+        }
+        case TRP_CBOR_TEXT: {
+            const char* text = reinterpret_cast<const char*>(item.payload);
+            size_t len = static_cast<size_t>(item.argument);
+            if ( node_arena ) return new (*node_arena) TrpJsonString(text, len, node_arena, intern_pool);
+            return new TrpJsonString(text, len, NULL, intern_pool);
+        }
+        case TRP_CBOR_ARRAY: case TRP_CBOR_MAP:
+            return parseContainer( item.major == TRP_CBOR_MAP );
+        default:
+            break;
+    }
+    switch ( item.info ) {
+        case TRP_CBOR_NULL:
+            return node_arena ? new (*node_arena) TrpJsonNull() : new TrpJsonNull();
+        case TRP_CBOR_TRUE:
+            return node_arena ? new (*node_arena) TrpJsonBool(true) : new TrpJsonBool(true);
+        case TRP_CBOR_FALSE:
+            return node_arena ? new (*node_arena) TrpJsonBool(false) : new TrpJsonBool(false);
+        default: {
+            double value = TrpJsonCbor::toDouble( item );
+            return node_arena ? new (*node_arena) TrpJsonNumber(value) : new TrpJsonNumber(value);
+        }
+    }
+}
+
+bool TrpJsonParser::parseCbor( const char* data, size_t len ) {
+    reset();
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = begin + len;
+    const unsigned char* p = begin;
+    AutoPointer<ITrpJsonValue> root;
+    ITrpJsonValue* root_node = NULL;
+    TrpJsonText key;
+    TrpCborHead h;
+
+    stack.clear();
+    while ( true ) {
+        if ( !stack.empty() ) {
+            TrpParseFrame& frame = stack.back();
+            // done: the count ran out or the break is here
+            if ( !frame.count || (frame.count == TRP_CBOR_OPEN_ENDED && p < end && *p == TRP_CBOR_BREAK) ) {
+                if ( frame.count ) ++p;
+                stack.pop_back();
+                if ( stack.empty() ) break;
+                continue;
+            }
+            if ( frame.count != TRP_CBOR_OPEN_ENDED ) --frame.count;
+            if ( frame.is_object ) {
+                const unsigned char* at = p;
+                TrpErrorCode code = TrpJsonCbor::checkItem( p, end, h );
+                if ( code == ERROR_NONE && h.major != TRP_CBOR_TEXT ) code = ERROR_CBOR_KEY_NOT_STRING;
+                if ( code != ERROR_NONE ) return failCbor( begin, at, code );
+                key = TrpJsonText( reinterpret_cast<const char*>(h.payload), static_cast<size_t>(h.argument),
+                        nodeArena(), intern_pool );
+            }
+        }
+
+        const unsigned char* at = p;
+        TrpErrorCode code = TrpJsonCbor::checkItem( p, end, h );
+        bool opened = code == ERROR_NONE && (h.major == TRP_CBOR_ARRAY || h.major == TRP_CBOR_MAP);
+        if ( opened && max_depth && stack.size() >= max_depth ) code = ERROR_MAX_DEPTH;
+        if ( code != ERROR_NONE ) {
+            releaseKey( key );
+            return failCbor( begin, at, code );
+        }
+
+        ITrpJsonValue* value = cborValue( h );
+        if ( stack.empty() ) {
+            root_node = value;
+            if ( !nodeArena() ) root.reset( value );
+        } else if ( stack.back().is_object ) {
+            static_cast<TrpJsonObject*>(stack.back().container)->add( key, value );
+        } else {
+            static_cast<TrpJsonArray*>(stack.back().container)->add( value );
+        }
+
+        if ( opened ) {
+            TrpParseFrame frame;
+            frame.container = value;
+            frame.open = 0;
+            frame.count = h.indefinite ? TRP_CBOR_OPEN_ENDED : static_cast<size_t>(h.argument);
+            frame.is_object = h.major == TRP_CBOR_MAP;
+            stack.push_back( frame );
+        } else if ( stack.empty() ) {
+            break;
+        }
+    }
+    if ( p != end ) return failCbor( begin, p, ERROR_CBOR_TRAILING_DATA );
+
+    root.release();
+    head = root_node;
+    parsed = true;
+    return true;
+}
@@ -0,0 +1,202 @@
+#include "../../include/parser/TrpJsonCborWriter.hpp"
+#include "../../include/values/TrpJsonObject.hpp"
+#include "../../include/values/TrpJsonArray.hpp"
+#include "../../include/values/TrpJsonString.hpp"
+#include "../../include/values/TrpJsonBool.hpp"
+#include "../../include/core/TrpJsonNumberParser.hpp"
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+TrpJsonCborWriter::TrpJsonCborWriter( void ) {}
+
+TrpJsonCborWriter::TrpJsonCborWriter( FILE* file ) : TrpJsonOutput(file) {}
+
+TrpJsonCborWriter::TrpJsonCborWriter( int fd ) : TrpJsonOutput(fd) {}
+
+void TrpJsonCborWriter::clear( void ) {
+    m_size = 0;
+    m_stack.clear();
+}
+
+// the initial byte and bytes of value after it, right in the buffer (an emptied fixed
+// one always has the room)
+void TrpJsonCborWriter::bigEndian( unsigned char initial, uint64_t value, size_t bytes ) {
+    if ( m_buffer.size() - m_size < 9 ) grow( 9 );
+    char* out = &m_buffer[m_size];
+    out[0] = static_cast<char>(initial);
+    for ( size_t i = bytes; i > 0; --i ) {
+        out[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+    m_size += bytes + 1;
+}
+
+// the argument in the fewest bytes it fits in, up to 23 it is in the initial byte itself
+void TrpJsonCborWriter::head( unsigned major, uint64_t argument ) {
+    unsigned char initial = static_cast<unsigned char>(major << 5);
+    if ( argument < TRP_CBOR_ARGUMENT_8 ) {
+        put( static_cast<char>(initial | argument) );
+        return;
+    }
+    unsigned info = argument <= 0xFF ? 24 : argument <= 0xFFFF ? 25 : argument <= 0xFFFFFFFFULL ? 26 : 27;
+    bigEndian( static_cast<unsigned char>(initial | info), argument, static_cast<size_t>(1) << (info - TRP_CBOR_ARGUMENT_8) );
+}
+
+// strings are valid UTF-8 already and CBOR has nothing to escape
+void TrpJsonCborWriter::writeText( const char* data, size_t len ) {
+    head( TRP_CBOR_TEXT, len );
+    append( data, len );
+}
+
+// -0 is an integer 0 here too, like in the text writer
+void TrpJsonCborWriter::writeInteger( bool negative, uint64_t magnitude ) {
+    if ( negative && magnitude ) head( TRP_CBOR_NEGATIVE, magnitude - 1 );
+    else head( TRP_CBOR_UNSIGNED, magnitude );
+}
+
+// 4 bytes when the float says exactly the same. the 2 byte ones are left out, few values
+// that are not integers fit them. infinity and NaN are null, like in the text writer
+void TrpJsonCborWriter::writeDouble( double value ) {
+    const unsigned char simple = TRP_CBOR_SIMPLE << 5;
+    if ( value != value || value - value != 0 ) {
+        put( static_cast<char>(simple | TRP_CBOR_NULL) );
+        return;
+    }
+    if ( std::fabs( value ) <= FLT_MAX ) {
+        float f = static_cast<float>(value);
+        if ( static_cast<double>(f) == value ) {
+            uint32_t bits;
+            std::memcpy( &bits, &f, sizeof(bits) );
+            bigEndian( simple | TRP_CBOR_FLOAT, bits, 4 );
+            return;
+        }
+    }
+    uint64_t bits;
+    std::memcpy( &bits, &value, sizeof(bits) );
+    bigEndian( simple | TRP_CBOR_DOUBLE, bits, 8 );
+}
+
+// integers exact, the same ones the text writer prints as integers
+void TrpJsonCborWriter::writeNumber( const TrpJsonNumber* number ) {
+    int64_t i;
+    uint64_t u;
+    if ( number->getUint64( u ) )
+        writeInteger( false, u );
+    else if ( number->getInt64( i ) )
+        writeInteger( true, 0 - static_cast<uint64_t>(i) );
+    else
+        writeDouble( number->getValue() );
+}
+
+void TrpJsonCborWriter::writeScalar( ITrpJsonValue* value ) {
+    const unsigned char simple = TRP_CBOR_SIMPLE << 5;
+    switch ( value ? value->getType() : TRP_NULL ) {
+        case TRP_STRING: {
+            TrpJsonString* str = static_cast<TrpJsonString*>(value);
+            writeText( str->data(), str->size() );
+            break;
+        }
+        case TRP_NUMBER:
+            writeNumber( static_cast<TrpJsonNumber*>(value) );
+            break;
+        case TRP_BOOL:
+            put( static_cast<char>(simple | (static_cast<TrpJsonBool*>(value)->getValue() ? TRP_CBOR_TRUE : TRP_CBOR_FALSE)) );
+            break;
+        default:
+            put( static_cast<char>(simple | TRP_CBOR_NULL) );
+            break;
+    }
+}
+
+// the text writer's loop: a container is opened with its count, then each turn writes the
+// next member / element. there is nothing to close, a counted container just ends
+bool TrpJsonCborWriter::write( ITrpJsonValue* value ) {
+    m_stack.clear();
+    while ( true ) {
+        TrpJsonType type = value ? value->getType() : TRP_NULL;
+        if ( type == TRP_OBJECT || type == TRP_ARRAY ) {
+            Frame frame;
+            frame.container = value;
+            frame.next = 0;
+            frame.is_object = type == TRP_OBJECT;
+            frame.size = frame.is_object ? static_cast<TrpJsonObject*>(value)->size()
+                                         : static_cast<TrpJsonArray*>(value)->size();
+            head( frame.is_object ? TRP_CBOR_MAP : TRP_CBOR_ARRAY, frame.size );
+            m_stack.push_back( frame );
+        } else {
+            writeScalar( value );
+        }
+
+        value = NULL;
+        while ( !m_stack.empty() && m_stack.back().next == m_stack.back().size )
+            m_stack.pop_back();
+        if ( m_stack.empty() ) break;
+
+        Frame& frame = m_stack.back();
+        size_t index = frame.next++;
+        if ( frame.is_object ) {
+            const JsonObjectEntry& entry = *(static_cast<TrpJsonObject*>(frame.container)->begin() + index);
+            writeText( entry.first.data(), entry.first.size() );
+            value = entry.second;
+        } else {
+            value = static_cast<TrpJsonArray*>(frame.container)->at( index );
+        }
+    }
+    return !m_failed;
+}
+
+// handler events, open ended containers so nothing has to be counted or kept
+
+bool TrpJsonCborWriter::onObjectStart( void ) {
+    put( static_cast<char>((TRP_CBOR_MAP << 5) | TRP_CBOR_INDEFINITE) );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onArrayStart( void ) {
+    put( static_cast<char>((TRP_CBOR_ARRAY << 5) | TRP_CBOR_INDEFINITE) );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onObjectEnd( size_t member_count ) {
+    (void)member_count;
+    put( static_cast<char>(TRP_CBOR_BREAK) );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onArrayEnd( size_t element_count ) {
+    (void)element_count;
+    put( static_cast<char>(TRP_CBOR_BREAK) );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onKey( const char* key, size_t len ) {
+    writeText( key, len );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onString( const char* data, size_t len ) {
+    writeText( data, len );
+    return !m_failed;
+}
+
+// number is only filled when lazy numbers are off, the lexeme is always there
+bool TrpJsonCborWriter::onNumber( const char* lexeme, size_t len, const TrpNumber& number ) {
+    (void)number;
+    TrpNumber parsed;
+    size_t length;
+    TrpJsonNumberParser::parse( lexeme, lexeme + len, parsed, length );
+    if ( parsed.is_integer ) writeInteger( parsed.negative, parsed.magnitude );
+    else writeDouble( parsed.value );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onBool( bool value ) {
+    put( static_cast<char>((TRP_CBOR_SIMPLE << 5) | (value ? TRP_CBOR_TRUE : TRP_CBOR_FALSE)) );
+    return !m_failed;
+}
+
+bool TrpJsonCborWriter::onNull( void ) {
+    put( static_cast<char>((TRP_CBOR_SIMPLE << 5) | TRP_CBOR_NULL) );
+    return !m_failed;
+}
@@ -0,0 +1,229 @@
+#include "../../include/parser/TrpJsonLines.hpp"
+#include <unistd.h>
+#include <cstring>
+
+TrpJsonLinesParser::TrpJsonLinesParser( void )
+    : m_threads(0), m_order(LINES_ORDERED), m_alloc_mode(ALLOC_ARENA), m_lazy_numbers(false),
+      m_max_depth(TRP_PARSER_MAX_DEPTH), m_intern_pool(NULL),
+      m_records(0), m_errors(0), m_stopped(false) {}
+
+TrpJsonLinesParser::~TrpJsonLinesParser( void ) {}
+
+void TrpJsonLinesParser::setThreads( size_t threads ) { m_threads = threads; }
+size_t TrpJsonLinesParser::getThreads( void ) const { return m_threads; }
+void TrpJsonLinesParser::setOrder( TrpLinesOrder order ) { m_order = order; }
+TrpLinesOrder TrpJsonLinesParser::getOrder( void ) const { return m_order; }
+
+void TrpJsonLinesParser::setAllocationMode( TrpAllocationMode mode ) { m_alloc_mode = mode; }
+void TrpJsonLinesParser::setLazyNumbers( bool enabled ) { m_lazy_numbers = enabled; }
+void TrpJsonLinesParser::setMaxDepth( size_t depth ) { m_max_depth = depth; }
+void TrpJsonLinesParser::setInternPool( TrpJsonInternPool* pool ) { m_intern_pool = pool; }
+
+size_t TrpJsonLinesParser::getRecordCount( void ) const { return m_records; }
+size_t TrpJsonLinesParser::getErrorCount( void ) const { return m_errors; }
+bool TrpJsonLinesParser::stoppedEarly( void ) const { return m_stopped; }
+
+// errors go in the records, printing them from every worker would only interleave
+void TrpJsonLinesParser::setupParser( TrpJsonParser& parser ) const {
+    parser.setAllocationMode( m_order == LINES_ORDERED ? ALLOC_HEAP : m_alloc_mode );
+    parser.setLazyNumbers( m_lazy_numbers );
+    parser.setMaxDepth( m_max_depth );
+    parser.setInternPool( m_intern_pool );
+    parser.setErrorStream( NULL );
+}
+
+static bool isBlank( const char* p, size_t len ) {
+    for ( size_t i = 0; i < len; ++i )
+        if ( p[i] != ' ' && p[i] != '\t' && p[i] != '\r' ) return false;
+    return true;
+}
+
+static size_t countLines( const char* p, const char* end ) {
+    size_t count = 0;
+    while ( p < end && (p = static_cast<const char*>(std::memchr( p, '\n', end - p ))) ) {
+        ++count;
+        ++p;
+    }
+    return count;
+}
+
+// runs on the calling thread while the workers already parse the first chunks
+void TrpJsonLinesParser::produceChunks( Batch& batch, const char* data, size_t len ) {
+    const char* p = data;
+    const char* end = data + len;
+    size_t line = 0;
+
+    while ( p < end ) {
+        const char* chunk_end = end;
+        if ( static_cast<size_t>(end - p) > TRP_LINES_CHUNK_BYTES ) {
+            const char* nl = static_cast<const char*>(std::memchr( p + TRP_LINES_CHUNK_BYTES, '\n',
+                end - p - TRP_LINES_CHUNK_BYTES ));
+            chunk_end = nl ? nl + 1 : end;
+        }
+        Chunk chunk = { p, chunk_end, line };
+        line += countLines( p, chunk_end );
+        p = chunk_end;
+
+        pthread_mutex_lock( &batch.lock );
+        bool stop = batch.stop;
+        if ( !stop ) batch.chunks.push_back( chunk );
+        pthread_cond_signal( &batch.ready );
+        pthread_mutex_unlock( &batch.lock );
+        if ( stop ) break;
+    }
+
+    pthread_mutex_lock( &batch.lock );
+    batch.produced = true;
+    pthread_cond_broadcast( &batch.ready );
+    pthread_mutex_unlock( &batch.lock );
+}
+
+bool TrpJsonLinesParser::takeChunk( Batch& batch, Chunk& chunk, size_t& id ) {
+    pthread_mutex_lock( &batch.lock );
+    while ( !batch.stop && !batch.produced && batch.next_chunk == batch.chunks.size() )
+        pthread_cond_wait( &batch.ready, &batch.lock );
+    bool taken = !batch.stop && batch.next_chunk < batch.chunks.size();
+    if ( taken ) {
+        id = batch.next_chunk++;
+        chunk = batch.chunks[id];
+    }
+    pthread_mutex_unlock( &batch.lock );
+    return taken;
+}
+
+void* TrpJsonLinesParser::workerMain( void* arg ) {
+    Batch* batch = static_cast<Batch*>(arg);
+    batch->owner->work( *batch );
+    return NULL;
+}
+
+// chunks are taken in input order, so ordered delivery only waits for the chunk right
+// before ours, never for one that nobody is working on
+void TrpJsonLinesParser::work( Batch& batch ) {
+    bool ordered = m_order == LINES_ORDERED;
+    TrpJsonParser parser;
+    setupParser( parser );
+    bool heap = parser.getAllocationMode() == ALLOC_HEAP;
+
+    std::vector<TrpJsonRecord> parsed;
+    size_t records = 0;
+    size_t errors = 0;
+    Chunk chunk;
+    size_t id;
+    while ( takeChunk( batch, chunk, id ) ) {
+        bool stop = false;
+        size_t line = chunk.first_line;
+        for ( const char* p = chunk.begin; p < chunk.end && !stop; ++line ) {
+            const char* eol = static_cast<const char*>(std::memchr( p, '\n', chunk.end - p ));
+            if ( !eol ) eol = chunk.end;
+
+            TrpJsonRecord record;
+            record.line = line;
+            record.text = p;
+            record.length = eol - p;
+            record.value = NULL;
+            record.error.clear();
+            p = eol < chunk.end ? eol + 1 : chunk.end;
+            if ( isBlank( record.text, record.length ) ) continue;
+            if ( record.text[record.length - 1] == '\r' ) --record.length;
+
+            ++records;
+            if ( parser.parse( record.text, record.length ) ) {
+                record.value = parser.getAST();
+            } else {
+                record.error = parser.getError();
+                ++errors;
+            }
+
+            if ( ordered ) {
+                parser.release();
+                parsed.push_back( record );
+                continue;
+            }
+            stop = !batch.handler->onRecord( record );
+            // the handler kept the tree, the next parse must not free it
+            if ( heap && !record.value ) parser.release();
+        }
+
+        if ( ordered ) {
+            pthread_mutex_lock( &batch.lock );
+            while ( batch.next_delivery != id )
+                pthread_cond_wait( &batch.turn, &batch.lock );
+            stop = batch.stop;
+            pthread_mutex_unlock( &batch.lock );
+
+            for ( size_t i = 0; i < parsed.size(); ++i ) {
+                if ( !stop ) stop = !batch.handler->onRecord( parsed[i] );
+                delete parsed[i].value;
+            }
+            parsed.clear();
+
+            pthread_mutex_lock( &batch.lock );
+            ++batch.next_delivery;
+            if ( stop ) batch.stop = true;
+            pthread_cond_broadcast( &batch.turn );
+            pthread_mutex_unlock( &batch.lock );
+        } else if ( stop ) {
+            pthread_mutex_lock( &batch.lock );
+            batch.stop = true;
+            pthread_mutex_unlock( &batch.lock );
+        }
+    }
+
+    pthread_mutex_lock( &batch.lock );
+    batch.records += records;
+    batch.errors += errors;
+    pthread_mutex_unlock( &batch.lock );
+}
+
+bool TrpJsonLinesParser::parse( const char* data, size_t len, ITrpJsonRecordHandler& handler ) {
+    Batch batch;
+    batch.owner = this;
+    batch.handler = &handler;
+    batch.next_chunk = 0;
+    batch.next_delivery = 0;
+    batch.produced = false;
+    batch.stop = false;
+    batch.records = 0;
+    batch.errors = 0;
+    pthread_mutex_init( &batch.lock, NULL );
+    pthread_cond_init( &batch.ready, NULL );
+    pthread_cond_init( &batch.turn, NULL );
+
+    size_t count = m_threads;
+    if ( !count ) {
+        long cores = sysconf( _SC_NPROCESSORS_ONLN );
+        count = cores > 0 ? static_cast<size_t>(cores) : 1;
+    }
+    // no point in more workers than chunks
+    size_t chunks = len / TRP_LINES_CHUNK_BYTES + 1;
+    if ( count > chunks ) count = chunks;
+
+    std::vector<pthread_t> workers;
+    for ( size_t i = 0; i < count; ++i ) {
+        pthread_t thread;
+        if ( pthread_create( &thread, NULL, workerMain, &batch ) != 0 ) break;
+        workers.push_back( thread );
+    }
+
+    produceChunks( batch, data, len );
+    // could not start a single thread, we do it ourselves
+    if ( workers.empty() ) work( batch );
+    for ( size_t i = 0; i < workers.size(); ++i )
+        pthread_join( workers[i], NULL );
+
+    m_records = batch.records;
+    m_errors = batch.errors;
+    m_stopped = batch.stop;
+    pthread_cond_destroy( &batch.turn );
+    pthread_cond_destroy( &batch.ready );
+    pthread_mutex_destroy( &batch.lock );
+    return true;
+}
+
+// the lexer only loads the file (mapped when it can be), it never tokenizes it
+bool TrpJsonLinesParser::parseFile( const std::string& file_name, ITrpJsonRecordHandler& handler ) {
+    TrpJsonLexer input( file_name );
+    if ( !input.isOpen() ) return false;
+    return parse( input.getInput(), input.getInputSize(), handler );
+}
@@ -0,0 +1,131 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+
+// on demand documents: a container is parsed one level at a time. its scalars are built,
+// its nested containers are skipped by bracket matching and only remember where they
+// start, they get their own level the first time someone looks inside
+
+ITrpJsonValue* TrpJsonParser::deferContainer( token& current_token, size_t depth ) {
+    if ( max_depth && depth > max_depth ) {
+        fail( current_token, 0, ERROR_MAX_DEPTH );
+        return NULL;
+    }
+    const char* text = lexer->skipContainer();
+    if ( !text ) {
+        fail( current_token, 0, ERROR_UNTERMINATED_CONTAINER );
+        return NULL;
+    }
+
+    TrpJsonArena* node_arena = nodeArena();
+    TrpJsonDeferred* source = node_arena
+        ? static_cast<TrpJsonDeferred*>(node_arena->allocate(sizeof(TrpJsonDeferred)))
+        : new TrpJsonDeferred;
+    source->materializer = this;
+    source->text = text;
+    source->line = current_token.line;
+    source->col = current_token.col;
+    source->depth = depth;
+    has_deferred = true;
+
+    ITrpJsonValue* container = parseContainer( current_token.type == T_BRACE_OPEN );
+    if ( current_token.type == T_BRACE_OPEN )
+        static_cast<TrpJsonObject*>(container)->defer( source );
+    else
+        static_cast<TrpJsonArray*>(container)->defer( source );
+    return container;
+}
+
+// current_token is the open bracket of container, depth is the container's own
+bool TrpJsonParser::parseLevel( token& current_token, ITrpJsonValue* container, size_t depth ) {
+    token& t = current_token;
+    bool is_object = t.type == T_BRACE_OPEN;
+    TrpTokenType close = is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE;
+    TrpJsonText key;
+
+    t = lexer->getNextToken();
+    if ( t.type == close ) return true;
+
+    for ( bool first = true; ; first = false ) {
+        if ( is_object && !parseKey( t, key, first ) ) return false;
+
+        ITrpJsonValue* value = NULL;
+        switch ( t.type ) {
+            case T_BRACE_OPEN: case T_BRACKET_OPEN:
+                value = deferContainer( t, depth + 1 );
+                break;
+            case T_STRING:
+                value = parseString( t );
+                break;
+            case T_NUMBER:
+                value = parseNumber( t );
+                break;
+            case T_TRUE: case T_FALSE: case T_NULL:
+                value = parseLiteral( t );
+                break;
+            case T_END_OF_FILE:
+            case T_ERROR:
+            default:
+                fail( t, TRP_EXPECT_VALUE | (first && !is_object ? TRP_EXPECT(close) : 0) );
+                break;
+        }
+        if ( !value ) {
+            if ( is_object ) key.release();
+            return false;
+        }
+
+        if ( is_object )
+            static_cast<TrpJsonObject*>(container)->add( key, value );
+        else
+            static_cast<TrpJsonArray*>(container)->add( value );
+
+        t = lexer->getNextToken();
+        if ( t.type == close ) return true;
+        if ( t.type != T_COMMA ) {
+            fail( t, TRP_EXPECT(T_COMMA) | TRP_EXPECT(close) );
+            return false;
+        }
+        t = lexer->getNextToken();
+    }
+}
+
+// the top level of an on demand parse, a scalar document is just parsed
+ITrpJsonValue* TrpJsonParser::parseOnDemand( token& current_token ) {
+    if ( current_token.type != T_BRACE_OPEN && current_token.type != T_BRACKET_OPEN )
+        return parseValue( current_token );
+
+    ITrpJsonValue* root = parseContainer( current_token.type == T_BRACE_OPEN );
+    if ( !parseLevel( current_token, root, 1 ) ) {
+        if ( !nodeArena() ) delete root;
+        return NULL;
+    }
+    return root;
+}
+
+// called by a deferred container the first time it is used
+bool TrpJsonParser::materialize( ITrpJsonValue* container, const TrpJsonDeferred& source ) {
+    lexer->seek( source.text, source.line, source.col );
+    token t = lexer->getNextToken();
+    return parseLevel( t, container, source.depth );
+}
+
+// whatever is still deferred gets parsed, after this the tree doesn't need the input
+void TrpJsonParser::materializeAll( void ) {
+    if ( !has_deferred || !head ) {
+        has_deferred = false;
+        return;
+    }
+    std::vector<ITrpJsonValue*> pending( 1, head );
+    while ( !pending.empty() ) {
+        ITrpJsonValue* value = pending.back();
+        pending.pop_back();
+        if ( value->getType() == TRP_ARRAY ) {
+            TrpJsonArray* arr = static_cast<TrpJsonArray*>(value);
+            for ( size_t i = 0; i < arr->size(); ++i )
+                pending.push_back( arr->at(i) );
+        } else if ( value->getType() == TRP_OBJECT ) {
+            TrpJsonObject* obj = static_cast<TrpJsonObject*>(value);
+            for ( JsonObjectVector::const_iterator it = obj->begin(); it != obj->end(); ++it )
+                pending.push_back( it->second );
+        }
+    }
+    has_deferred = false;
+}
@@ -0,0 +1,77 @@
+#include "../../include/parser/TrpJsonOutput.hpp"
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+TrpJsonOutput::TrpJsonOutput( void )
+    : m_sink(WRITER_BUFFER), m_file(NULL), m_fd(-1), m_size(0), m_failed(false) {}
+
+TrpJsonOutput::TrpJsonOutput( FILE* file )
+    : m_sink(WRITER_FILE), m_file(file), m_fd(-1), m_buffer(TRP_WRITER_BUFFER_BYTES),
+      m_size(0), m_failed(!file) {}
+
+TrpJsonOutput::TrpJsonOutput( int fd )
+    : m_sink(WRITER_FD), m_file(NULL), m_fd(fd), m_buffer(TRP_WRITER_BUFFER_BYTES),
+      m_size(0), m_failed(fd < 0) {}
+
+TrpJsonOutput::~TrpJsonOutput( void ) {
+    flush();
+}
+
+bool TrpJsonOutput::failed( void ) const { return m_failed; }
+
+const char* TrpJsonOutput::data( void ) const { return m_size ? &m_buffer[0] : ""; }
+size_t TrpJsonOutput::size( void ) const { return m_size; }
+std::string TrpJsonOutput::str( void ) const { return std::string( data(), m_size ); }
+
+bool TrpJsonOutput::drain( const char* data, size_t len ) {
+    if ( m_failed ) return false;
+    if ( m_sink == WRITER_FILE ) {
+        if ( std::fwrite( data, 1, len, m_file ) != len ) m_failed = true;
+        return !m_failed;
+    }
+    while ( len ) {
+        ssize_t n = ::write( m_fd, data, len );
+        if ( n < 0 && errno == EINTR ) continue;
+        if ( n <= 0 ) {
+            m_failed = true;
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool TrpJsonOutput::flush( void ) {
+    if ( m_sink == WRITER_BUFFER ) return true;
+    if ( m_size ) drain( &m_buffer[0], m_size );
+    m_size = 0;
+    if ( m_sink == WRITER_FILE && !m_failed && std::fflush( m_file ) != 0 ) m_failed = true;
+    return !m_failed;
+}
+
+// room for len more bytes: the buffer sink doubles, the others write out what they have
+void TrpJsonOutput::grow( size_t len ) {
+    if ( m_sink != WRITER_BUFFER ) {
+        flush();
+        return;
+    }
+    size_t capacity = m_buffer.size() ? m_buffer.size() : 256;
+    while ( capacity - m_size < len )
+        capacity *= 2;
+    m_buffer.resize( capacity );
+}
+
+void TrpJsonOutput::append( const char* data, size_t len ) {
+    if ( m_buffer.size() - m_size < len ) {
+        grow( len );
+        // bigger than the whole fixed buffer, no point in copying it first
+        if ( m_buffer.size() - m_size < len ) {
+            drain( data, len );
+            return;
+        }
+    }
+    std::memcpy( &m_buffer[m_size], data, len );
+    m_size += len;
+}
@@ -0,0 +1,181 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+#include <pthread.h>
+#include <unistd.h>
+#include <deque>
+
+// one huge top level array on several threads. this thread only cuts the array between
+// elements (strings and brackets are all it looks at) while helper parsers, one per thread,
+// already parse the pieces. the elements are put back in order in one array at the end
+
+struct TrpParallelChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<ITrpJsonValue*> elements;
+};
+
+struct TrpParallelBatch
+{
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    // a deque so the chunks don't move while helpers fill them
+    std::deque<TrpParallelChunk> chunks;
+    size_t next_chunk;
+    bool produced;
+    bool failed;
+};
+
+struct TrpParallelWorker
+{
+    TrpParallelBatch* batch;
+    TrpJsonParser* helper;
+};
+
+bool TrpJsonParser::parallelInput( void ) const {
+    // the helpers parse one level down, a limit of 1 has no room for that
+    return threads != 1 && !on_demand && max_depth != 1
+        && lexer->getInputSize() > 2 * TRP_PARALLEL_CHUNK_BYTES;
+}
+
+void TrpJsonParser::releaseHelpers( void ) {
+    for ( size_t i = 0; i < helpers.size(); ++i )
+        delete helpers[i];
+    helpers.clear();
+}
+
+// the elements of [begin, end) are appended to out, nothing is reset so the ones
+// already parsed by this helper stay alive in its arena
+bool TrpJsonParser::parseElements( const char* begin, const char* end, std::vector<ITrpJsonValue*>& out ) {
+    size_t first = out.size();
+    useInput( begin, end - begin );
+
+    token t = lexer->getNextToken();
+    while ( true ) {
+        ITrpJsonValue* value = parseValue( t );
+        if ( !value ) break;
+        out.push_back( value );
+
+        t = lexer->getNextToken();
+        if ( t.type == T_END_OF_FILE ) return true;
+        if ( t.type != T_COMMA ) break;
+        t = lexer->getNextToken();
+    }
+    if ( !nodeArena() ) {
+        for ( size_t i = first; i < out.size(); ++i )
+            delete out[i];
+    }
+    out.resize( first );
+    return false;
+}
+
+void* TrpJsonParser::parallelWorker( void* arg ) {
+    TrpParallelWorker* worker = static_cast<TrpParallelWorker*>(arg);
+    TrpParallelBatch& batch = *worker->batch;
+
+    while ( true ) {
+        pthread_mutex_lock( &batch.lock );
+        while ( !batch.failed && !batch.produced && batch.next_chunk == batch.chunks.size() )
+            pthread_cond_wait( &batch.ready, &batch.lock );
+        if ( batch.failed || batch.next_chunk == batch.chunks.size() ) {
+            pthread_mutex_unlock( &batch.lock );
+            break;
+        }
+        TrpParallelChunk& chunk = batch.chunks[batch.next_chunk++];
+        pthread_mutex_unlock( &batch.lock );
+
+        if ( !worker->helper->parseElements( chunk.begin, chunk.end, chunk.elements ) ) {
+            pthread_mutex_lock( &batch.lock );
+            batch.failed = true;
+            pthread_cond_broadcast( &batch.ready );
+            pthread_mutex_unlock( &batch.lock );
+            break;
+        }
+    }
+    return NULL;
+}
+
+// the open bracket was the last token. NULL on any error, parse() then starts over
+ITrpJsonValue* TrpJsonParser::parseParallel( void ) {
+    size_t count = threads;
+    if ( !count ) {
+        long cores = sysconf( _SC_NPROCESSORS_ONLN );
+        count = cores > 0 ? static_cast<size_t>(cores) : 1;
+    }
+
+    TrpParallelBatch batch;
+    batch.next_chunk = 0;
+    batch.produced = false;
+    batch.failed = false;
+    pthread_mutex_init( &batch.lock, NULL );
+    pthread_cond_init( &batch.ready, NULL );
+
+    releaseHelpers();
+    std::vector<TrpParallelWorker> workers( count );
+    std::vector<pthread_t> running;
+    for ( size_t i = 0; i < count; ++i ) {
+        TrpJsonParser* helper = new TrpJsonParser();
+        helper->setAllocationMode( alloc_mode );
+        helper->setLazyNumbers( lazy_numbers );
+        helper->setMaxDepth( max_depth ? max_depth - 1 : 0 );
+        helper->setInternPool( intern_pool );
+        helper->setErrorStream( NULL );
+        helpers.push_back( helper );
+
+        workers[i].batch = &batch;
+        workers[i].helper = helper;
+        pthread_t thread;
+        if ( pthread_create( &thread, NULL, parallelWorker, &workers[i] ) != 0 ) break;
+        running.push_back( thread );
+    }
+
+    const char* begin = lexer->position();
+    bool closed = false;
+    while ( !closed ) {
+        const char* cut = lexer->skipElements( TRP_PARALLEL_CHUNK_BYTES );
+        pthread_mutex_lock( &batch.lock );
+        if ( !cut ) batch.failed = true;
+        if ( !batch.failed ) {
+            TrpParallelChunk chunk;
+            chunk.begin = begin;
+            chunk.end = cut;
+            batch.chunks.push_back( chunk );
+            pthread_cond_signal( &batch.ready );
+        }
+        bool failed = batch.failed;
+        pthread_mutex_unlock( &batch.lock );
+        if ( failed ) break;
+        closed = *cut == ']';
+        begin = cut + 1;
+    }
+
+    pthread_mutex_lock( &batch.lock );
+    batch.produced = true;
+    pthread_cond_broadcast( &batch.ready );
+    pthread_mutex_unlock( &batch.lock );
+    // no thread could be started, the first helper does it all here
+    if ( running.empty() && !batch.failed ) parallelWorker( &workers[0] );
+    for ( size_t i = 0; i < running.size(); ++i )
+        pthread_join( running[i], NULL );
+    pthread_cond_destroy( &batch.ready );
+    pthread_mutex_destroy( &batch.lock );
+
+    TrpJsonArray* root = NULL;
+    if ( !batch.failed ) {
+        root = static_cast<TrpJsonArray*>(parseContainer( false ));
+        for ( size_t i = 0; i < batch.chunks.size(); ++i ) {
+            std::vector<ITrpJsonValue*>& elements = batch.chunks[i].elements;
+            for ( size_t k = 0; k < elements.size(); ++k )
+                root->add( elements[k] );
+        }
+    } else if ( !nodeArena() ) {
+        for ( size_t i = 0; i < batch.chunks.size(); ++i ) {
+            std::vector<ITrpJsonValue*>& elements = batch.chunks[i].elements;
+            for ( size_t k = 0; k < elements.size(); ++k )
+                delete elements[k];
+        }
+    }
+
+    // heap elements belong to the array now, arena ones still live in the helpers
+    if ( !root || !nodeArena() ) releaseHelpers();
+    return root;
+}
@@ -1,11 +1,11 @@
 #include "../../include/parser/TrpJsonParser.hpp"
 
-TrpJsonParser::TrpJsonParser( const std::string _file_name ) : parsed(false) {
+TrpJsonParser::TrpJsonParser( const std::string _file_name ) : parsed(false), use_structural_index(false), lazy_numbers(false), alloc_mode(ALLOC_HEAP), intern_pool(NULL), max_depth(TRP_PARSER_MAX_DEPTH), stopped(false), on_demand(false), has_deferred(false), error_stream(NULL), threads(1), push_state(PUSH_IDLE), push_in_string(false), push_escaped(false), push_line(0), push_col(0), push_offset(0) {
     head = NULL;
     lexer = new TrpJsonLexer(_file_name);
 }
 
-TrpJsonParser::TrpJsonParser( void ) : parsed(false) {
+TrpJsonParser::TrpJsonParser( void ) : parsed(false), use_structural_index(false), lazy_numbers(false), alloc_mode(ALLOC_HEAP), intern_pool(NULL), max_depth(TRP_PARSER_MAX_DEPTH), stopped(false), on_demand(false), has_deferred(false), error_stream(NULL), threads(1), push_state(PUSH_IDLE), push_in_string(false), push_escaped(false), push_line(0), push_col(0), push_offset(0) {
     head = NULL;
     lexer = NULL;
 }
@@ -17,194 +17,401 @@ void TrpJsonParser::setLexer( TrpJsonLexer* _lexer ) {
 
 void TrpJsonParser::resetLexer( TrpJsonLexer* new_lexer ) {
     if ( !new_lexer || !new_lexer->isOpen() ) return;
+    // deferred containers still read from the old input
+    materializeAll();
     if ( lexer ) delete lexer;
     lexer = new_lexer;
 }
 
+// the lexer we have is pointed at the next input so its scratch and index memory stay,
+// there is only a new one the first time
+void TrpJsonParser::useInput( const char* data, size_t len ) {
+    // deferred containers still read from the old input
+    materializeAll();
+    if ( lexer ) lexer->setInput( data, len );
+    else lexer = new TrpJsonLexer( data, len );
+    lexer->setStructuralIndex( use_structural_index );
+    lexer->setLazyNumbers( lazy_numbers );
+}
+
+void TrpJsonParser::setStructuralIndex( bool enabled ) {
+    use_structural_index = enabled;
+    if ( lexer ) lexer->setStructuralIndex( enabled );
+}
+
+void TrpJsonParser::setLazyNumbers( bool enabled ) {
+    lazy_numbers = enabled;
+    if ( lexer ) lexer->setLazyNumbers( enabled );
+}
+
+void TrpJsonParser::setMaxDepth( size_t depth ) { max_depth = depth; }
+size_t TrpJsonParser::getMaxDepth( void ) const { return max_depth; }
+
+void TrpJsonParser::setOnDemand( bool enabled ) { on_demand = enabled; }
+bool TrpJsonParser::isOnDemand( void ) const { return on_demand; }
+
+void TrpJsonParser::setErrorStream( std::ostream* stream ) { error_stream = stream; }
+
+void TrpJsonParser::setThreads( size_t _threads ) { threads = _threads; }
+size_t TrpJsonParser::getThreads( void ) const { return threads; }
+
+void TrpJsonParser::setAllocationMode( TrpAllocationMode mode ) {
+    if ( mode == alloc_mode ) return;
+    clearAST();
+    alloc_mode = mode;
+    if ( alloc_mode == ALLOC_HEAP ) arena.release();
+}
+
+TrpAllocationMode TrpJsonParser::getAllocationMode( void ) const { return alloc_mode; }
+const TrpJsonArena& TrpJsonParser::getArena( void ) const { return arena; }
+
+void TrpJsonParser::setInternPool( TrpJsonInternPool* pool ) { intern_pool = pool; }
+TrpJsonInternPool* TrpJsonParser::getInternPool( void ) const { return intern_pool; }
+
+TrpJsonArena* TrpJsonParser::nodeArena( void ) {
+    return alloc_mode == ALLOC_ARENA ? &arena : NULL;
+}
+
 ITrpJsonValue* TrpJsonParser::getAST( void ) const { return head; }
 bool TrpJsonParser::isParsed( void ) const { return parsed; }
-const token& TrpJsonParser::getLastError( void ) const { return last_err; }
+bool TrpJsonParser::stoppedEarly( void ) const { return stopped; }
+const TrpJsonError& TrpJsonParser::getError( void ) const { return error; }
+
+const token& TrpJsonParser::getLastError( void ) const {
+    if ( error.code != ERROR_NONE && last_err.value.empty() ) last_err.value = error.message();
+    return last_err;
+}
 
 void TrpJsonParser::lastError( token t ) {
-    if ( t.type != T_ERROR ) t.value = "Unexpected token";
-    std::cerr << lexer->getFileName() << ":"
-    << t.line << ":"
-    << t.col << " "
-    << "Error: " << t.value << std::endl;
-    last_err = t;
+    fail( t, 0 );
+}
+
+// the failure path of every parse: a few stores, no string and no stream unless asked for.
+// the detail is copied now, the bytes it points at may not outlive the next token
+void TrpJsonParser::fail( const token& t, unsigned expected, TrpErrorCode code ) {
+    if ( code == ERROR_NONE )
+        code = t.type == T_ERROR ? t.error : t.type == T_END_OF_FILE ? ERROR_UNEXPECTED_END : ERROR_UNEXPECTED_TOKEN;
+    error.code = code;
+    error.offset = t.offset;
+    error.line = t.line;
+    error.col = t.col;
+    error.expected = expected;
+    error.detail_length = 0;
+    if ( t.type == T_ERROR && t.error == code ) error.setDetail( t.text, t.length );
+
+    last_err.type = T_ERROR;
+    last_err.value.clear();
+    last_err.line = t.line;
+    last_err.col = t.col;
+    last_err.offset = t.offset;
+    last_err.error = code;
+    last_err.text = NULL;
+    last_err.length = 0;
+
+    if ( !error_stream ) return;
+    *error_stream << (lexer ? lexer->getFileName() : std::string()) << ":"
+    << error.line << ":"
+    << error.col << " "
+    << "Error: " << error.message() << std::endl;
+}
+
+// nothing to parse is an error like any other, there is just no position
+bool TrpJsonParser::checkInput( void ) {
+    if ( lexer && lexer->isOpen() ) return true;
+    token t;
+    t.type = T_ERROR;
+    t.line = t.col = t.offset = 0;
+    t.error = lexer ? lexer->getInputError() : ERROR_NO_INPUT;
+    if ( t.error == ERROR_NONE ) t.error = ERROR_NO_INPUT;
+    t.text = NULL;
+    t.length = 0;
+    fail( t, 0 );
+    return false;
 }
 
+// the arena keeps its memory for the next document
 void TrpJsonParser::clearAST( void ) {
+    has_deferred = false;
+    if ( alloc_mode == ALLOC_ARENA ) {
+        head = NULL;
+        arena.reset();
+        releaseHelpers();
+        return;
+    }
     delete head;
     head = NULL;
 }
 
 void TrpJsonParser::reset( void ) {
+    // a push parse still going is dropped with its tree
+    if ( push_state != PUSH_IDLE && push_state != PUSH_FAILED ) failPush();
+    push_state = PUSH_IDLE;
+    push_pending.clear();
     clearAST();
     parsed = false;
+    clearError();
+}
+
+void TrpJsonParser::clearError( void ) {
+    error.clear();
     last_err.type = T_ERROR;
     last_err.value.clear();
     last_err.col = 0;
     last_err.line = 0;
+    last_err.offset = 0;
+    last_err.error = ERROR_NONE;
+}
+
+// everything kept for the next document goes back, for after an unusually big one
+void TrpJsonParser::trim( void ) {
+    reset();
+    arena.release();
+    std::vector<TrpParseFrame>().swap( stack );
+    std::string().swap( push_pending );
+    // a file lexer is still needed by parse(), memory ones come back on the next input
+    if ( lexer && lexer->getInputMode() == LEXER_INPUT_MEMORY ) {
+        delete lexer;
+        lexer = NULL;
+    }
 }
 
 ITrpJsonValue* TrpJsonParser::release( void ) {
+    if ( alloc_mode == ALLOC_ARENA ) return NULL;
+    materializeAll();
     ITrpJsonValue* tmp = head;
     head = NULL;
     return tmp;
 }
 
 TrpJsonParser::~TrpJsonParser( void ) {
+    if ( push_state != PUSH_IDLE && push_state != PUSH_FAILED ) failPush();
     clearAST();
     delete lexer;
     lexer = NULL;
 }
 
-ITrpJsonValue* TrpJsonParser::parseValue( token& current_token ) {
-
-    switch (current_token.type)
-    {
-        case T_BRACE_OPEN:
-            return parseObject( current_token );
-        case T_BRACKET_OPEN:
-            return parseArray( current_token );
-        case T_STRING:
-            return parseString( current_token );
-        case T_NUMBER:
-            return parseNumber( current_token );
-        case T_TRUE: case T_FALSE: case T_NULL:
-            return parseLiteral( current_token );
-        case T_END_OF_FILE:
-            break;
-        case T_ERROR:
-        default:
-            lastError( current_token );
-            break;
-    }
-
-    return NULL;
-}
-
-bool TrpJsonParser::parse( void ) {
-    if ( !lexer ) {
-        std::cerr << "Error: No file provided." << std::endl;
+// the key of the next member: leaves current_token on the first token of its value.
+// first is right after the '{', where '}' would have been fine too
+bool TrpJsonParser::parseKey( token& current_token, TrpJsonText& key, bool first ) {
+    if ( current_token.type != T_STRING ) {
+        fail( current_token, TRP_EXPECT(T_STRING) | (first ? TRP_EXPECT(T_BRACE_CLOSE) : 0) );
         return false;
     }
+    // copy the key now, the next token can overwrite the lexer scratch
+    key = TrpJsonText( current_token.text, current_token.length, nodeArena(), intern_pool );
 
-    token t = lexer->getNextToken();
-    head = parseValue(t);
-    
-    t = lexer->getNextToken();
-    if (t.type != T_END_OF_FILE) {
-        lastError( t );
-        clearAST();
+    current_token = lexer->getNextToken();
+    if ( current_token.type != T_COLON ) {
+        key.release();
+        fail( current_token, TRP_EXPECT(T_COLON) );
         return false;
     }
+    current_token = lexer->getNextToken();
+    return true;
+}
 
-    if ( head != NULL ) {
-        parsed = true;
-        return true;
+bool TrpJsonParser::pushContainer( token& current_token ) {
+    if ( max_depth && stack.size() >= max_depth ) {
+        fail( current_token, 0, ERROR_MAX_DEPTH );
+        return false;
     }
-    return false;
+    TrpParseFrame frame;
+    frame.is_object = current_token.type == T_BRACE_OPEN;
+    frame.container = NULL;
+    frame.open = 0;
+    frame.count = 0;
+    stack.push_back( frame );
+    return true;
 }
 
-ITrpJsonValue* TrpJsonParser::parseArray( token& current_token ) {
-    if ( current_token.type != T_BRACKET_OPEN ) return NULL;
-
-    AutoPointer<TrpJsonArray> arr_ptr(new TrpJsonArray());
+// the key belongs to the object once its value is added, it is only ours while we are
+// inside an object and haven't built the value yet
+void TrpJsonParser::releaseKey( TrpJsonText& key ) {
+    if ( !stack.empty() && stack.back().is_object )
+        key.release();
+}
 
-    token t = lexer->getNextToken();
-    if ( t.type == T_BRACKET_CLOSE ) return arr_ptr.release();
+ITrpJsonValue* TrpJsonParser::parseContainer( bool is_object ) {
+    TrpJsonArena* node_arena = nodeArena();
+    if ( is_object )
+        return node_arena ? new (*node_arena) TrpJsonObject(node_arena) : new TrpJsonObject();
+    return node_arena ? new (*node_arena) TrpJsonArray(node_arena) : new TrpJsonArray();
+}
 
+// no recursion: open arrays and objects sit on our own stack, so nesting is only bounded by
+// max_depth. every node is hooked to its parent as soon as it exists, on errors deleting the
+// root cleans up everything (and in arena mode there is nothing to clean)
+ITrpJsonValue* TrpJsonParser::parseValue( token& current_token ) {
+    AutoPointer<ITrpJsonValue> root;
+    ITrpJsonValue* root_node = NULL;
+    TrpJsonText key;
+    token& t = current_token;
+    // what the grammar allowed where t is, for the error
+    unsigned expected = TRP_EXPECT_VALUE;
+
+    stack.clear();
     while ( true ) {
-        ITrpJsonValue* tmp_value = parseValue(t);
-        if ( !tmp_value ) return NULL;
+        ITrpJsonValue* value;
+        bool opened = false;
+        switch ( t.type ) {
+            case T_BRACE_OPEN: case T_BRACKET_OPEN:
+                if ( !pushContainer( t ) ) {
+                    releaseKey( key );
+                    return NULL;
+                }
+                value = parseContainer( t.type == T_BRACE_OPEN );
+                stack.back().container = value;
+                opened = true;
+                break;
+            case T_STRING:
+                value = parseString( t );
+                break;
+            case T_NUMBER:
+                value = parseNumber( t );
+                break;
+            case T_TRUE: case T_FALSE: case T_NULL:
+                value = parseLiteral( t );
+                break;
+            case T_END_OF_FILE:
+            case T_ERROR:
+            default:
+                releaseKey( key );
+                fail( t, expected );
+                return NULL;
+        }
 
-        arr_ptr->add(tmp_value);
+        size_t parent = stack.size() - (opened ? 1 : 0);
+        if ( !parent ) {
+            root_node = value;
+            if ( !nodeArena() ) root.reset( value );
+        } else if ( stack[parent - 1].is_object ) {
+            static_cast<TrpJsonObject*>(stack[parent - 1].container)->add( key, value );
+        } else {
+            static_cast<TrpJsonArray*>(stack[parent - 1].container)->add( value );
+        }
+        if ( stack.empty() ) break;
 
         t = lexer->getNextToken();
-        if ( t.type == T_BRACKET_CLOSE ) {
-            break;
-        } else if ( t.type == T_COMMA ) {
+        if ( opened ) {
+            if ( t.type != (stack.back().is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE) ) {
+                if ( stack.back().is_object && !parseKey( t, key, true ) ) return NULL;
+                expected = TRP_EXPECT_VALUE | (stack.back().is_object ? 0 : TRP_EXPECT(T_BRACKET_CLOSE));
+                continue;
+            }
+            stack.pop_back();
+            if ( stack.empty() ) break;
             t = lexer->getNextToken();
-            continue;
-        } else {
-            lastError( t );
-            return NULL;
         }
+
+        // after a value: a comma starts the next one, a close finishes the container
+        // and we are after a value again one level up
+        bool next_value = false;
+        while ( !stack.empty() ) {
+            TrpTokenType close = stack.back().is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE;
+            if ( t.type == T_COMMA ) {
+                t = lexer->getNextToken();
+                if ( stack.back().is_object && !parseKey( t, key, false ) ) return NULL;
+                expected = TRP_EXPECT_VALUE;
+                next_value = true;
+                break;
+            }
+            if ( t.type != close ) {
+                fail( t, TRP_EXPECT(T_COMMA) | TRP_EXPECT(close) );
+                return NULL;
+            }
+            stack.pop_back();
+            if ( !stack.empty() ) t = lexer->getNextToken();
+        }
+        if ( !next_value ) break;
     }
 
-    return arr_ptr.release();
+    root.release();
+    return root_node;
 }
 
-ITrpJsonValue* TrpJsonParser::parseObject( token& current_token ) {
-    if ( current_token.type != T_BRACE_OPEN ) return NULL;
-
-    AutoPointer<TrpJsonObject> obj_ptr( new TrpJsonObject() );
+bool TrpJsonParser::parse( void ) {
+    if ( !checkInput() ) return false;
 
     token t = lexer->getNextToken();
-    if ( t.type == T_BRACE_CLOSE ) return obj_ptr.release();
-
-    while ( true ) {
-        if ( t.type != T_STRING ) {
-            lastError( t );
-            return NULL;
+    ITrpJsonValue* root = NULL;
+    if ( t.type == T_BRACKET_OPEN && parallelInput() ) {
+        root = parseParallel();
+        // anything wrong is parsed again on this thread, that is where errors get their position
+        if ( !root ) {
+            lexer->reset();
+            t = lexer->getNextToken();
         }
+    }
+    head = root ? root : on_demand ? parseOnDemand(t) : parseValue(t);
+    // the error is already reported, whatever follows it would only add noise
+    if ( !head ) return false;
 
-        std::string key = t.value;
+    t = lexer->getNextToken();
+    if (t.type != T_END_OF_FILE) {
+        fail( t, TRP_EXPECT(T_END_OF_FILE) );
+        clearAST();
+        return false;
+    }
 
-        t = lexer->getNextToken();
-        if ( t.type != T_COLON ) {
-            lastError( t );
-            return NULL;
-        };
+    parsed = true;
+    return true;
+}
 
-        t = lexer->getNextToken();
-        ITrpJsonValue* tmp_value = parseValue( t );
-        if ( !tmp_value ) {
-            return NULL;
-        }
-        obj_ptr->add(key, tmp_value);
+bool TrpJsonParser::parse( const char* data, size_t len ) {
+    reset();
+    useInput( data, len );
+    return parse();
+}
 
-        t = lexer->getNextToken();
-        if ( t.type == T_BRACE_CLOSE ) {
-            break;
-        } else if ( t.type == T_COMMA ) {
-            t = lexer->getNextToken();
-            continue;
-        } else {
-            lastError( t );
-            return NULL;
-        }
-    }
+bool TrpJsonParser::parseFile( const std::string& file_name ) {
+    reset();
+    if ( lexer ) lexer->setInput( file_name );
+    else lexer = new TrpJsonLexer( file_name );
+    if ( !checkInput() ) return false;
+    lexer->setStructuralIndex( use_structural_index );
+    lexer->setLazyNumbers( lazy_numbers );
+    return parse();
+}
 
-    return obj_ptr.release();
+bool TrpJsonParser::parseString( const std::string& json ) {
+    return parse( json.data(), json.size() );
 }
 
 ITrpJsonValue* TrpJsonParser::parseString( token& current_token ) {
     if ( current_token.type != T_STRING ) return NULL;
 
-    return new TrpJsonString(current_token.value);
+    TrpJsonArena* node_arena = nodeArena();
+    if ( node_arena )
+        return new (*node_arena) TrpJsonString(current_token.text, current_token.length, node_arena, intern_pool);
+    return new TrpJsonString(current_token.text, current_token.length, NULL, intern_pool);
 }
 
 ITrpJsonValue* TrpJsonParser::parseNumber( token& current_token ) {
     if ( current_token.type != T_NUMBER ) return NULL;
 
-    double value = std::atof(current_token.value.c_str());
-    return new TrpJsonNumber(value);
+    TrpJsonArena* node_arena = nodeArena();
+    if ( node_arena ) {
+        if ( lexer->hasLazyNumbers() )
+            return new (*node_arena) TrpJsonNumber(current_token.text, current_token.length, node_arena);
+        return new (*node_arena) TrpJsonNumber(current_token.number);
+    }
+    if ( lexer->hasLazyNumbers() )
+        return new TrpJsonNumber(current_token.text, current_token.length);
+    return new TrpJsonNumber(current_token.number);
 }
 
 ITrpJsonValue* TrpJsonParser::parseLiteral( token& current_token ) {
     if ( !(current_token.type == T_NULL || current_token.type == T_TRUE || current_token.type == T_FALSE) )
         return NULL;
     
+    TrpJsonArena* node_arena = nodeArena();
     switch (current_token.type) {
         case T_NULL:
-            return new TrpJsonNull();
+            return node_arena ? new (*node_arena) TrpJsonNull() : new TrpJsonNull();
         case T_TRUE:
-            return new TrpJsonBool(true);
+            return node_arena ? new (*node_arena) TrpJsonBool(true) : new TrpJsonBool(true);
         case T_FALSE:
-            return new TrpJsonBool(false);
+            return node_arena ? new (*node_arena) TrpJsonBool(false) : new TrpJsonBool(false);
         default:
             return NULL;
     }
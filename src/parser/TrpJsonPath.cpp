@@ -0,0 +1,213 @@
+#include "../../include/parser/TrpJsonPath.hpp"
+#include "../../include/values/TrpJsonObject.hpp"
+#include "../../include/values/TrpJsonArray.hpp"
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+
+// "0" or no leading zero, RFC 6901 array index rules (dotted paths use the same)
+static bool parseIndex( const std::string& text, size_t& index ) {
+    if ( text.empty() || text.size() > 19 ) return false;
+    if ( text.size() > 1 && text[0] == '0' ) return false;
+    index = 0;
+    for ( size_t i = 0; i < text.size(); ++i ) {
+        if ( text[i] < '0' || text[i] > '9' ) return false;
+        index = index * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+TrpJsonPath::TrpJsonPath( void ) : m_valid(true), m_wildcard(false) {}
+
+bool TrpJsonPath::fail( const std::string& message, size_t offset ) {
+    std::ostringstream os;
+    os << message << " at offset " << offset;
+    m_error = os.str();
+    m_steps.clear();
+    m_valid = false;
+    m_wildcard = false;
+    return false;
+}
+
+void TrpJsonPath::addKey( const std::string& key, bool indexable ) {
+    TrpPathStep step;
+    step.kind = PATH_KEY;
+    step.key = key;
+    step.index = 0;
+    step.has_index = indexable && parseIndex( key, step.index );
+    m_steps.push_back( step );
+}
+
+void TrpJsonPath::addIndex( size_t index ) {
+    TrpPathStep step;
+    step.kind = PATH_INDEX;
+    step.index = index;
+    step.has_index = true;
+    m_steps.push_back( step );
+}
+
+void TrpJsonPath::addWildcard( void ) {
+    TrpPathStep step;
+    step.kind = PATH_WILDCARD;
+    step.index = 0;
+    step.has_index = false;
+    m_steps.push_back( step );
+    m_wildcard = true;
+}
+
+// "" is the root, every other pointer is a list of "/token", ~0 is ~ and ~1 is /
+bool TrpJsonPath::compilePointer( const std::string& pointer ) {
+    m_steps.clear();
+    m_error.clear();
+    m_valid = true;
+    m_wildcard = false;
+    if ( pointer.empty() ) return true;
+    if ( pointer[0] != '/' ) return fail( "JSON Pointer must start with '/'", 0 );
+
+    std::string key;
+    for ( size_t i = 1; i <= pointer.size(); ++i ) {
+        if ( i == pointer.size() || pointer[i] == '/' ) {
+            addKey( key, true );
+            key.clear();
+            continue;
+        }
+        if ( pointer[i] != '~' ) {
+            key += pointer[i];
+            continue;
+        }
+        if ( i + 1 < pointer.size() && pointer[i + 1] == '0' ) key += '~';
+        else if ( i + 1 < pointer.size() && pointer[i + 1] == '1' ) key += '/';
+        else return fail( "Invalid escape in JSON Pointer", i );
+        ++i;
+    }
+    return true;
+}
+
+// key(.key)*, with [n] / [*] after any key and * as a whole key for every member.
+// keys that are plain numbers also pick array elements, like pointer tokens do
+bool TrpJsonPath::compile( const std::string& path ) {
+    m_steps.clear();
+    m_error.clear();
+    m_valid = true;
+    m_wildcard = false;
+
+    size_t i = 0;
+    bool need_key = false;
+    while ( i < path.size() ) {
+        if ( path[i] == '[' ) {
+            if ( need_key ) return fail( "Expected a key", i );
+            size_t close = path.find( ']', i );
+            if ( close == std::string::npos ) return fail( "Missing ']'", i );
+            std::string inside = path.substr( i + 1, close - i - 1 );
+            size_t index;
+            if ( inside == "*" ) addWildcard();
+            else if ( parseIndex( inside, index ) ) addIndex( index );
+            else return fail( "Expected an index or '*' in brackets", i + 1 );
+            i = close + 1;
+        } else if ( path[i] == '.' ) {
+            if ( need_key || i == 0 ) return fail( "Expected a key", i );
+            need_key = true;
+            ++i;
+            continue;
+        } else {
+            if ( !need_key && i != 0 ) return fail( "Expected '.' or '['", i );
+            size_t end = path.find_first_of( ".[", i );
+            if ( end == std::string::npos ) end = path.size();
+            std::string key = path.substr( i, end - i );
+            if ( key == "*" ) addWildcard();
+            else if ( key.find( ']' ) != std::string::npos ) return fail( "Unexpected ']'", i + key.find( ']' ) );
+            else addKey( key, true );
+            i = end;
+        }
+        need_key = false;
+    }
+    if ( need_key ) return fail( "Expected a key", i );
+    return true;
+}
+
+bool TrpJsonPath::isValid( void ) const { return m_valid; }
+const std::string& TrpJsonPath::getError( void ) const { return m_error; }
+bool TrpJsonPath::hasWildcard( void ) const { return m_wildcard; }
+size_t TrpJsonPath::size( void ) const { return m_steps.size(); }
+const TrpPathStep& TrpJsonPath::step( size_t index ) const { return m_steps[index]; }
+
+bool TrpJsonPath::matchesKey( const TrpPathStep& step, const char* key, size_t len ) {
+    if ( step.kind == PATH_WILDCARD ) return true;
+    return step.kind == PATH_KEY && step.key.size() == len
+        && std::memcmp( step.key.data(), key, len ) == 0;
+}
+
+bool TrpJsonPath::matchesIndex( const TrpPathStep& step, size_t index ) {
+    if ( step.kind == PATH_WILDCARD ) return true;
+    return step.has_index && step.index == index;
+}
+
+// without a wildcard there is at most one match, a straight walk down
+ITrpJsonValue* TrpJsonPath::find( ITrpJsonValue* root ) const {
+    if ( !m_valid || !root ) return NULL;
+    if ( m_wildcard ) {
+        std::vector<ITrpJsonValue*> out;
+        return collect( root, out, true ) ? out[0] : NULL;
+    }
+
+    ITrpJsonValue* value = root;
+    for ( size_t i = 0; i < m_steps.size() && value; ++i ) {
+        const TrpPathStep& s = m_steps[i];
+        if ( value->getType() == TRP_OBJECT && s.kind == PATH_KEY ) {
+            value = static_cast<TrpJsonObject*>(value)->find( s.key.data(), s.key.size() );
+        } else if ( value->getType() == TRP_ARRAY && s.has_index ) {
+            TrpJsonArray* arr = static_cast<TrpJsonArray*>(value);
+            value = s.index < arr->size() ? arr->at( s.index ) : NULL;
+        } else {
+            value = NULL;
+        }
+    }
+    return value;
+}
+
+size_t TrpJsonPath::findAll( ITrpJsonValue* root, std::vector<ITrpJsonValue*>& out ) const {
+    if ( !m_valid || !root ) return 0;
+    return collect( root, out, false );
+}
+
+// own stack of (value, next step), children pushed backwards so matches come out in order
+size_t TrpJsonPath::collect( ITrpJsonValue* root, std::vector<ITrpJsonValue*>& out, bool first_only ) const {
+    std::vector<std::pair<ITrpJsonValue*, size_t> > pending;
+    size_t found = 0;
+
+    pending.push_back( std::make_pair( root, static_cast<size_t>(0) ) );
+    while ( !pending.empty() ) {
+        ITrpJsonValue* value = pending.back().first;
+        size_t i = pending.back().second;
+        pending.pop_back();
+
+        if ( i == m_steps.size() ) {
+            out.push_back( value );
+            ++found;
+            if ( first_only ) break;
+            continue;
+        }
+        const TrpPathStep& s = m_steps[i];
+        if ( value->getType() == TRP_OBJECT ) {
+            TrpJsonObject* obj = static_cast<TrpJsonObject*>(value);
+            if ( s.kind == PATH_KEY ) {
+                ITrpJsonValue* child = obj->find( s.key.data(), s.key.size() );
+                if ( child ) pending.push_back( std::make_pair( child, i + 1 ) );
+            } else if ( s.kind == PATH_WILDCARD ) {
+                size_t mark = pending.size();
+                for ( JsonObjectVector::const_iterator it = obj->begin(); it != obj->end(); ++it )
+                    pending.push_back( std::make_pair( it->second, i + 1 ) );
+                std::reverse( pending.begin() + mark, pending.end() );
+            }
+        } else if ( value->getType() == TRP_ARRAY ) {
+            TrpJsonArray* arr = static_cast<TrpJsonArray*>(value);
+            if ( s.kind == PATH_WILDCARD ) {
+                for ( size_t k = arr->size(); k > 0; --k )
+                    pending.push_back( std::make_pair( arr->at( k - 1 ), i + 1 ) );
+            } else if ( s.has_index && s.index < arr->size() ) {
+                pending.push_back( std::make_pair( arr->at( s.index ), i + 1 ) );
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,238 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+#include "../../include/core/TrpJsonSimd.hpp"
+#include <cstring>
+
+// push parsing. a chunk is only lexed up to its last delimiter outside a string (whitespace,
+// { } [ ] : , or a closing quote), no token goes across one, so every token in that piece is
+// whole. the rest waits in push_pending for the next chunk
+
+static bool isPushDelimiter( char c ) {
+    switch (c) {
+        case ' ': case '\t': case '\n': case '\r':
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// goes on from the state push_pending ended in. returns the byte after the first (or last)
+// delimiter, NULL if there is none. scanning for the first one stops right there
+const char* TrpJsonParser::pushScan( const char* p, const char* end, bool first ) {
+    const char* cut = NULL;
+    while (p < end) {
+        if (push_in_string) {
+            if (push_escaped) {
+                push_escaped = false;
+                ++p;
+                continue;
+            }
+            p += TrpJsonSimd::findStringSpecial(p, end - p);
+            if (p == end)
+                break;
+            if (*p == '\\') {
+                push_escaped = true;
+            } else if (*p == '"') {
+                push_in_string = false;
+                cut = p + 1;
+                if (first)
+                    return cut;
+            }
+            ++p;
+            continue;
+        }
+        char c = *p++;
+        if (c == '"') {
+            push_in_string = true;
+        } else if (isPushDelimiter(c)) {
+            cut = p;
+            if (first)
+                return cut;
+        }
+    }
+    return cut;
+}
+
+// what may come in each state, for the error
+static unsigned pushExpected( TrpPushState state, bool in_object ) {
+    switch ( state ) {
+        case PUSH_VALUE: return TRP_EXPECT_VALUE;
+        case PUSH_FIRST_VALUE: return TRP_EXPECT_VALUE | TRP_EXPECT(T_BRACKET_CLOSE);
+        case PUSH_KEY: return TRP_EXPECT(T_STRING);
+        case PUSH_FIRST_KEY: return TRP_EXPECT(T_STRING) | TRP_EXPECT(T_BRACE_CLOSE);
+        case PUSH_COLON: return TRP_EXPECT(T_COLON);
+        case PUSH_AFTER_VALUE: return TRP_EXPECT(T_COMMA) | TRP_EXPECT(in_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE);
+        case PUSH_DONE: return TRP_EXPECT(T_END_OF_FILE);
+        default: return 0;
+    }
+}
+
+// a piece of whole tokens, positions are moved to where the piece is in the document
+bool TrpJsonParser::pushSegment( const char* data, size_t len ) {
+    useInput( data, len );
+
+    token t = lexer->getNextToken();
+    while ( t.type != T_END_OF_FILE ) {
+        if ( t.line == 0 ) t.col += push_col;
+        t.line += push_line;
+        t.offset += push_offset;
+        if ( !pushToken( t ) ) return false;
+        t = lexer->getNextToken();
+    }
+
+    const char* end = data + len;
+    const char* line_start = NULL;
+    for ( const char* p = data; (p = static_cast<const char*>(std::memchr( p, '\n', end - p ))); ) {
+        line_start = ++p;
+        ++push_line;
+    }
+    push_col = line_start ? end - line_start : push_col + len;
+    push_offset += len;
+    return true;
+}
+
+// the key is ours until its value is added
+bool TrpJsonParser::failPush( void ) {
+    if ( push_state == PUSH_COLON || (push_state == PUSH_VALUE && !stack.empty() && stack.back().is_object) )
+        push_key.release();
+    push_state = PUSH_FAILED;
+    clearAST();
+    return false;
+}
+
+bool TrpJsonParser::pushClose( void ) {
+    stack.pop_back();
+    push_state = stack.empty() ? PUSH_DONE : PUSH_AFTER_VALUE;
+    return true;
+}
+
+// same as a turn of parseValue(), the node is hooked to its parent right away
+bool TrpJsonParser::pushValue( token& current_token ) {
+    ITrpJsonValue* value;
+    bool opened = false;
+    switch ( current_token.type ) {
+        case T_BRACE_OPEN: case T_BRACKET_OPEN:
+            if ( !pushContainer( current_token ) ) return failPush();
+            value = parseContainer( current_token.type == T_BRACE_OPEN );
+            stack.back().container = value;
+            opened = true;
+            break;
+        case T_STRING:
+            value = parseString( current_token );
+            break;
+        case T_NUMBER:
+            value = parseNumber( current_token );
+            break;
+        case T_TRUE: case T_FALSE: case T_NULL:
+            value = parseLiteral( current_token );
+            break;
+        default:
+            fail( current_token, pushExpected( push_state, !stack.empty() && stack.back().is_object ) );
+            return failPush();
+    }
+
+    size_t parent = stack.size() - (opened ? 1 : 0);
+    if ( !parent )
+        head = value;
+    else if ( stack[parent - 1].is_object )
+        static_cast<TrpJsonObject*>(stack[parent - 1].container)->add( push_key, value );
+    else
+        static_cast<TrpJsonArray*>(stack[parent - 1].container)->add( value );
+
+    if ( opened )
+        push_state = stack.back().is_object ? PUSH_FIRST_KEY : PUSH_FIRST_VALUE;
+    else
+        push_state = stack.empty() ? PUSH_DONE : PUSH_AFTER_VALUE;
+    return true;
+}
+
+bool TrpJsonParser::pushToken( token& current_token ) {
+    token& t = current_token;
+    switch ( push_state ) {
+        case PUSH_FIRST_KEY:
+            if ( t.type == T_BRACE_CLOSE ) return pushClose();
+            // fall through
+        case PUSH_KEY:
+            if ( t.type != T_STRING ) break;
+            push_key = TrpJsonText( t.text, t.length, nodeArena(), intern_pool );
+            push_state = PUSH_COLON;
+            return true;
+        case PUSH_COLON:
+            if ( t.type != T_COLON ) break;
+            push_state = PUSH_VALUE;
+            return true;
+        case PUSH_FIRST_VALUE:
+            if ( t.type == T_BRACKET_CLOSE ) return pushClose();
+            // fall through
+        case PUSH_VALUE:
+            return pushValue( t );
+        case PUSH_AFTER_VALUE:
+            if ( t.type == T_COMMA ) {
+                push_state = stack.back().is_object ? PUSH_KEY : PUSH_VALUE;
+                return true;
+            }
+            if ( t.type == (stack.back().is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE) ) return pushClose();
+            break;
+        default:
+            break;
+    }
+    fail( t, pushExpected( push_state, !stack.empty() && stack.back().is_object ) );
+    return failPush();
+}
+
+bool TrpJsonParser::feed( const char* data, size_t len ) {
+    if ( push_state == PUSH_IDLE ) {
+        reset();
+        stack.clear();
+        push_state = PUSH_VALUE;
+        push_in_string = push_escaped = false;
+        push_line = push_col = push_offset = 0;
+    }
+    if ( push_state == PUSH_FAILED ) return false;
+
+    const char* p = data;
+    const char* end = data + len;
+    // the token cut last time, only the bytes up to its end are copied next to it
+    if ( !push_pending.empty() ) {
+        const char* cut = pushScan( p, end, true );
+        if ( !cut ) {
+            push_pending.append( p, len );
+            return true;
+        }
+        push_pending.append( p, cut - p );
+        bool ok = pushSegment( push_pending.data(), push_pending.size() );
+        push_pending.clear();
+        if ( !ok ) return false;
+        p = cut;
+    }
+
+    // the rest is lexed in place
+    const char* cut = pushScan( p, end, false );
+    if ( cut ) {
+        if ( !pushSegment( p, cut - p ) ) return false;
+        p = cut;
+    }
+    push_pending.assign( p, end - p );
+    return true;
+}
+
+// whatever is left is a whole token now, the root has to be complete
+bool TrpJsonParser::finish( void ) {
+    if ( push_state == PUSH_IDLE ) feed( "", 0 );
+
+    bool ok = push_state != PUSH_FAILED && pushSegment( push_pending.data(), push_pending.size() );
+    if ( ok && push_state != PUSH_DONE ) {
+        token t;
+        t.type = T_END_OF_FILE;
+        t.line = push_line;
+        t.col = push_col;
+        t.offset = push_offset;
+        t.error = ERROR_NONE;
+        fail( t, pushExpected( push_state, !stack.empty() && stack.back().is_object ) );
+        ok = failPush();
+    }
+    push_pending.clear();
+    push_state = PUSH_IDLE;
+    parsed = ok;
+    return ok;
+}
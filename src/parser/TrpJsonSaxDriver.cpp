@@ -0,0 +1,128 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+
+// same grammar and stack as the tree parser, every value becomes a handler call and
+// nothing is kept past it. a handler saying no sets stopped and ends the parse
+
+bool TrpJsonParser::saxKey( token& current_token, ITrpJsonHandler& handler, bool first ) {
+    if ( current_token.type != T_STRING ) {
+        fail( current_token, TRP_EXPECT(T_STRING) | (first ? TRP_EXPECT(T_BRACE_CLOSE) : 0) );
+        return false;
+    }
+    if ( !handler.onKey( current_token.text, current_token.length ) ) {
+        stopped = true;
+        return false;
+    }
+
+    current_token = lexer->getNextToken();
+    if ( current_token.type != T_COLON ) {
+        fail( current_token, TRP_EXPECT(T_COLON) );
+        return false;
+    }
+    current_token = lexer->getNextToken();
+    return true;
+}
+
+bool TrpJsonParser::saxClose( ITrpJsonHandler& handler ) {
+    const TrpParseFrame& top = stack.back();
+    bool go = top.is_object ? handler.onObjectEnd( top.count ) : handler.onArrayEnd( top.count );
+    stack.pop_back();
+    if ( !go ) stopped = true;
+    return go;
+}
+
+// true when the value went through (or the handler stopped), false on errors
+bool TrpJsonParser::saxValue( token& current_token, ITrpJsonHandler& handler ) {
+    token& t = current_token;
+    unsigned expected = TRP_EXPECT_VALUE;
+
+    stack.clear();
+    while ( true ) {
+        bool opened = false;
+        bool go;
+        switch ( t.type ) {
+            case T_BRACE_OPEN: case T_BRACKET_OPEN:
+                if ( !pushContainer( t ) ) return false;
+                opened = true;
+                go = stack.back().is_object ? handler.onObjectStart() : handler.onArrayStart();
+                break;
+            case T_STRING:
+                go = handler.onString( t.text, t.length );
+                break;
+            case T_NUMBER:
+                go = handler.onNumber( t.text, t.length, t.number );
+                break;
+            case T_TRUE: case T_FALSE:
+                go = handler.onBool( t.type == T_TRUE );
+                break;
+            case T_NULL:
+                go = handler.onNull();
+                break;
+            case T_END_OF_FILE:
+            case T_ERROR:
+            default:
+                fail( t, expected );
+                return false;
+        }
+        if ( !go ) {
+            stopped = true;
+            return true;
+        }
+
+        size_t parent = stack.size() - (opened ? 1 : 0);
+        if ( parent ) ++stack[parent - 1].count;
+        if ( stack.empty() ) return true;
+
+        t = lexer->getNextToken();
+        if ( opened ) {
+            if ( t.type != (stack.back().is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE) ) {
+                if ( stack.back().is_object && !saxKey( t, handler, true ) ) return stopped;
+                expected = TRP_EXPECT_VALUE | (stack.back().is_object ? 0 : TRP_EXPECT(T_BRACKET_CLOSE));
+                continue;
+            }
+            if ( !saxClose( handler ) || stack.empty() ) return true;
+            t = lexer->getNextToken();
+        }
+
+        bool next_value = false;
+        while ( !stack.empty() ) {
+            TrpTokenType close = stack.back().is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE;
+            if ( t.type == T_COMMA ) {
+                t = lexer->getNextToken();
+                if ( stack.back().is_object && !saxKey( t, handler, false ) ) return stopped;
+                expected = TRP_EXPECT_VALUE;
+                next_value = true;
+                break;
+            }
+            if ( t.type != close ) {
+                fail( t, TRP_EXPECT(T_COMMA) | TRP_EXPECT(close) );
+                return false;
+            }
+            if ( !saxClose( handler ) ) return true;
+            if ( !stack.empty() ) t = lexer->getNextToken();
+        }
+        if ( !next_value ) return true;
+    }
+}
+
+bool TrpJsonParser::parse( ITrpJsonHandler& handler ) {
+    stopped = false;
+    clearError();
+    if ( !checkInput() ) return false;
+
+    token t = lexer->getNextToken();
+    if ( !saxValue( t, handler ) ) return false;
+    // whatever comes after a stop is never looked at
+    if ( stopped ) return true;
+
+    t = lexer->getNextToken();
+    if ( t.type != T_END_OF_FILE ) {
+        fail( t, TRP_EXPECT(T_END_OF_FILE) );
+        return false;
+    }
+    return true;
+}
+
+bool TrpJsonParser::parse( const char* data, size_t len, ITrpJsonHandler& handler ) {
+    useInput( data, len );
+    return parse( handler );
+}
@@ -0,0 +1,118 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+
+// path queries on raw input: only the members / elements on the path are tokenized, every
+// other subtree is jumped over by bracket matching and only what matches becomes a node
+
+bool TrpJsonParser::skipContainer( token& current_token ) {
+    if ( lexer->skipContainer() ) return true;
+    fail( current_token, 0, ERROR_UNTERMINATED_CONTAINER );
+    return false;
+}
+
+bool TrpJsonParser::skipValue( token& current_token ) {
+    switch ( current_token.type ) {
+        case T_BRACE_OPEN: case T_BRACKET_OPEN:
+            return skipContainer( current_token );
+        case T_STRING: case T_NUMBER: case T_TRUE: case T_FALSE: case T_NULL:
+            return true;
+        default:
+            fail( current_token, TRP_EXPECT_VALUE );
+            return false;
+    }
+}
+
+// current_token is the value reached after `step` steps. recursion only goes as deep as the
+// path is long. without a wildcard the one match ends up in found and we stop right there
+bool TrpJsonParser::selectValue( token& current_token, const TrpJsonPath& path, size_t step,
+        TrpJsonArray* matches, ITrpJsonValue*& found ) {
+    token& t = current_token;
+    if ( step == path.size() ) {
+        ITrpJsonValue* value = on_demand ? parseOnDemand( t ) : parseValue( t );
+        if ( !value ) return false;
+        if ( matches ) matches->add( value );
+        else found = value;
+        return true;
+    }
+
+    const TrpPathStep& s = path.step( step );
+    bool is_object = t.type == T_BRACE_OPEN;
+    if ( !is_object && t.type != T_BRACKET_OPEN ) return skipValue( t );
+    TrpTokenType close = is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE;
+
+    t = lexer->getNextToken();
+    if ( t.type == close ) return true;
+    for ( size_t index = 0; ; ++index ) {
+        bool match;
+        if ( is_object ) {
+            if ( t.type != T_STRING ) {
+                fail( t, TRP_EXPECT(T_STRING) | (index ? 0 : TRP_EXPECT(close)) );
+                return false;
+            }
+            match = TrpJsonPath::matchesKey( s, t.text, t.length );
+            t = lexer->getNextToken();
+            if ( t.type != T_COLON ) {
+                fail( t, TRP_EXPECT(T_COLON) );
+                return false;
+            }
+            t = lexer->getNextToken();
+        } else {
+            match = TrpJsonPath::matchesIndex( s, index );
+        }
+
+        if ( match ) {
+            if ( !selectValue( t, path, step + 1, matches, found ) ) return false;
+            if ( found ) return true;
+            // a key or index picks one child, the rest of the container can't match
+            if ( s.kind != PATH_WILDCARD ) return skipContainer( t );
+        } else if ( !skipValue( t ) ) {
+            return false;
+        }
+
+        t = lexer->getNextToken();
+        if ( t.type == close ) return true;
+        if ( t.type != T_COMMA ) {
+            fail( t, TRP_EXPECT(T_COMMA) | TRP_EXPECT(close) );
+            return false;
+        }
+        t = lexer->getNextToken();
+    }
+}
+
+bool TrpJsonParser::select( const TrpJsonPath& path ) {
+    if ( !checkInput() ) return false;
+    token t = lexer->getNextToken();
+    if ( !path.isValid() ) {
+        t.type = T_ERROR;
+        t.error = ERROR_INVALID_PATH;
+        t.text = path.getError().data();
+        t.length = path.getError().size();
+        fail( t, 0 );
+        return false;
+    }
+
+    TrpJsonArray* matches = path.hasWildcard() ? static_cast<TrpJsonArray*>(parseContainer( false )) : NULL;
+    ITrpJsonValue* found = NULL;
+    bool ok = selectValue( t, path, 0, matches, found );
+    // the whole input was walked only when nothing stopped us early
+    if ( ok && !found ) {
+        t = lexer->getNextToken();
+        if ( t.type != T_END_OF_FILE ) {
+            fail( t, TRP_EXPECT(T_END_OF_FILE) );
+            ok = false;
+        }
+    }
+    if ( !ok ) {
+        if ( !nodeArena() ) delete matches;
+        return false;
+    }
+
+    head = matches ? matches : found;
+    parsed = true;
+    return true;
+}
+
+bool TrpJsonParser::select( const char* data, size_t len, const TrpJsonPath& path ) {
+    reset();
+    useInput( data, len );
+    return select( path );
+}
@@ -0,0 +1,142 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+#include <cstring>
+
+// same grammar and the same explicit stack as the tree parser, the values just end up
+// on a tape instead of the heap
+
+// keys go on the tape right away so there is nothing to copy out of the lexer scratch
+bool TrpJsonParser::tapeKey( token& current_token, TrpJsonTape& tape, bool first ) {
+    if ( current_token.type != T_STRING ) {
+        fail( current_token, TRP_EXPECT(T_STRING) | (first ? TRP_EXPECT(T_BRACE_CLOSE) : 0) );
+        return false;
+    }
+    tape.appendString( current_token.text, current_token.length );
+
+    current_token = lexer->getNextToken();
+    if ( current_token.type != T_COLON ) {
+        fail( current_token, TRP_EXPECT(T_COLON) );
+        return false;
+    }
+    current_token = lexer->getNextToken();
+    return true;
+}
+
+bool TrpJsonParser::tapeValue( token& current_token, TrpJsonTape& tape ) {
+    token& t = current_token;
+    unsigned expected = TRP_EXPECT_VALUE;
+
+    stack.clear();
+    while ( true ) {
+        bool opened = false;
+        switch ( t.type ) {
+            case T_BRACE_OPEN: case T_BRACKET_OPEN:
+                if ( !pushContainer( t ) ) return false;
+                stack.back().open = tape.append( t.type == T_BRACE_OPEN ? '{' : '[', 0 );
+                opened = true;
+                break;
+            case T_STRING:
+                tape.appendString( t.text, t.length );
+                break;
+            case T_NUMBER:
+                tapeNumber( t, tape );
+                break;
+            case T_TRUE:
+                tape.append( 't', 0 );
+                break;
+            case T_FALSE:
+                tape.append( 'f', 0 );
+                break;
+            case T_NULL:
+                tape.append( 'n', 0 );
+                break;
+            case T_END_OF_FILE:
+            case T_ERROR:
+            default:
+                fail( t, expected );
+                return false;
+        }
+
+        size_t parent = stack.size() - (opened ? 1 : 0);
+        if ( parent ) ++stack[parent - 1].count;
+        if ( stack.empty() ) return true;
+
+        t = lexer->getNextToken();
+        if ( opened ) {
+            if ( t.type != (stack.back().is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE) ) {
+                if ( stack.back().is_object && !tapeKey( t, tape, true ) ) return false;
+                expected = TRP_EXPECT_VALUE | (stack.back().is_object ? 0 : TRP_EXPECT(T_BRACKET_CLOSE));
+                continue;
+            }
+            tape.closeContainer( stack.back().open, stack.back().is_object ? '}' : ']', 0 );
+            stack.pop_back();
+            if ( stack.empty() ) return true;
+            t = lexer->getNextToken();
+        }
+
+        bool next_value = false;
+        while ( !stack.empty() ) {
+            TrpParseFrame& top = stack.back();
+            TrpTokenType close = top.is_object ? T_BRACE_CLOSE : T_BRACKET_CLOSE;
+            if ( t.type == T_COMMA ) {
+                t = lexer->getNextToken();
+                if ( top.is_object && !tapeKey( t, tape, false ) ) return false;
+                expected = TRP_EXPECT_VALUE;
+                next_value = true;
+                break;
+            }
+            if ( t.type != close ) {
+                fail( t, TRP_EXPECT(T_COMMA) | TRP_EXPECT(close) );
+                return false;
+            }
+            tape.closeContainer( top.open, top.is_object ? '}' : ']', top.count );
+            stack.pop_back();
+            if ( !stack.empty() ) t = lexer->getNextToken();
+        }
+        if ( !next_value ) return true;
+    }
+}
+
+// negative integers go as int64, the rest as uint64, anything else is a double
+void TrpJsonParser::tapeNumber( token& current_token, TrpJsonTape& tape ) {
+    TrpNumber number = current_token.number;
+    if ( lexer->hasLazyNumbers() ) {
+        size_t length;
+        TrpJsonNumberParser::parse( current_token.text, current_token.text + current_token.length, number, length );
+    }
+
+    const uint64_t int64_limit = static_cast<uint64_t>(1) << 63;
+    if ( number.is_integer && !number.negative ) {
+        tape.appendNumber( 'u', number.magnitude );
+    } else if ( number.is_integer && number.magnitude <= int64_limit ) {
+        tape.appendNumber( 'l', 0 - number.magnitude );
+    } else {
+        uint64_t bits;
+        std::memcpy( &bits, &number.value, sizeof(bits) );
+        tape.appendNumber( 'd', bits );
+    }
+}
+
+bool TrpJsonParser::parse( TrpJsonTape& tape ) {
+    tape.clear();
+    clearError();
+    if ( !checkInput() ) return false;
+
+    token t = lexer->getNextToken();
+    if ( !tapeValue( t, tape ) ) {
+        tape.clear();
+        return false;
+    }
+
+    t = lexer->getNextToken();
+    if ( t.type != T_END_OF_FILE ) {
+        fail( t, TRP_EXPECT(T_END_OF_FILE) );
+        tape.clear();
+        return false;
+    }
+    return true;
+}
+
+bool TrpJsonParser::parse( const char* data, size_t len, TrpJsonTape& tape ) {
+    useInput( data, len );
+    return parse( tape );
+}
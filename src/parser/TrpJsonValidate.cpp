@@ -0,0 +1,122 @@
+#include "../../include/parser/TrpJsonParser.hpp"
+#include <cctype>
+#include <cstring>
+
+// validation runs straight over the bytes: no token, no line count, nothing unescaped or
+// converted, the stack only knows what closes what. it is the lexer's grammar (the same
+// string, number and literal rules) so when it says no, the tokenizer goes over the input
+// once more to find out where and why, that is the one place errors come from
+
+static inline const char* skipSpace( const char* p, const char* end ) {
+    while ( p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') ) ++p;
+    return p;
+}
+
+// a literal is its letters and nothing glued to them
+static inline const char* scanLiteral( const char* p, const char* end, const char* rest, size_t len ) {
+    if ( static_cast<size_t>(end - p) < len || std::memcmp( p, rest, len ) ) return NULL;
+    p += len;
+    if ( p < end && (std::isalnum( static_cast<unsigned char>(*p) ) || *p == '_') ) return NULL;
+    return p;
+}
+
+// key, ':' and the space up to the value
+const char* TrpJsonParser::validateKey( const char* p, const char* end, TrpJsonStats& stats ) {
+    p = skipSpace( p, end );
+    if ( p == end || *p != '"' ) return NULL;
+    size_t length;
+    p = TrpJsonLexer::scanString( p + 1, end, length );
+    if ( !p ) return NULL;
+    if ( length > stats.max_string_length ) stats.max_string_length = length;
+    p = skipSpace( p, end );
+    if ( p == end || *p != ':' ) return NULL;
+    return p + 1;
+}
+
+bool TrpJsonParser::validateInput( const char* p, const char* end, TrpJsonStats& stats ) {
+    stack.clear();
+    while ( true ) {
+        p = skipSpace( p, end );
+        if ( p == end ) return false;
+        ++stats.values;
+        size_t length;
+        char c = *p++;
+        switch ( c ) {
+            case '{': case '[': {
+                if ( max_depth && stack.size() >= max_depth ) return false;
+                TrpParseFrame frame;
+                frame.container = NULL;
+                frame.open = frame.count = 0;
+                frame.is_object = c == '{';
+                stack.push_back( frame );
+                if ( stack.size() > stats.depth ) stats.depth = stack.size();
+                p = skipSpace( p, end );
+                if ( p < end && *p == (frame.is_object ? '}' : ']') ) {
+                    ++p;
+                    stack.pop_back();
+                    break;
+                }
+                if ( frame.is_object && !(p = validateKey( p, end, stats )) ) return false;
+                continue;
+            }
+            case '"':
+                if ( !(p = TrpJsonLexer::scanString( p, end, length )) ) return false;
+                if ( length > stats.max_string_length ) stats.max_string_length = length;
+                break;
+            case '-':
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                if ( TrpJsonNumberParser::scan( p - 1, end, length ) != NUMBER_OK ) return false;
+                p += length - 1;
+                break;
+            case 't':
+                if ( !(p = scanLiteral( p, end, "rue", 3 )) ) return false;
+                break;
+            case 'f':
+                if ( !(p = scanLiteral( p, end, "alse", 4 )) ) return false;
+                break;
+            case 'n':
+                if ( !(p = scanLiteral( p, end, "ull", 3 )) ) return false;
+                break;
+            default:
+                return false;
+        }
+
+        // after a value: a comma starts the next one, a close goes one level up
+        while ( true ) {
+            p = skipSpace( p, end );
+            if ( stack.empty() ) return p == end;
+            if ( p == end ) return false;
+            if ( *p == ',' ) {
+                ++p;
+                if ( stack.back().is_object && !(p = validateKey( p, end, stats )) ) return false;
+                break;
+            }
+            if ( *p != (stack.back().is_object ? '}' : ']') ) return false;
+            ++p;
+            stack.pop_back();
+        }
+    }
+}
+
+bool TrpJsonParser::validate( TrpJsonStats& stats ) {
+    stats.depth = 0;
+    stats.values = 0;
+    stats.max_string_length = 0;
+    clearError();
+    if ( !checkInput() ) return false;
+
+    const char* input = lexer->getInput();
+    if ( validateInput( input, input + lexer->getInputSize(), stats ) ) return true;
+
+    // somewhere it is wrong, the handler parse says where (and builds nothing either)
+    ITrpJsonHandler nothing;
+    lexer->reset();
+    parse( nothing );
+    return false;
+}
+
+bool TrpJsonParser::validate( const char* data, size_t len, TrpJsonStats& stats ) {
+    useInput( data, len );
+    return validate( stats );
+}
@@ -0,0 +1,329 @@
+#include "../../include/parser/TrpJsonWriter.hpp"
+#include "../../include/values/TrpJsonObject.hpp"
+#include "../../include/values/TrpJsonArray.hpp"
+#include "../../include/values/TrpJsonString.hpp"
+#include "../../include/values/TrpJsonBool.hpp"
+#include "../../include/core/TrpJsonSimd.hpp"
+#include "../../include/core/TrpJsonNumberFormat.hpp"
+#include "../../include/parser/TrpJsonColors.hpp"
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+
+TrpJsonWriter::TrpJsonWriter( void )
+    : m_indent(0), m_fill(' '), m_colors(false), m_sort_keys(false), m_after_key(false) {}
+
+TrpJsonWriter::TrpJsonWriter( FILE* file )
+    : TrpJsonOutput(file), m_indent(0), m_fill(' '), m_colors(false), m_sort_keys(false),
+      m_after_key(false) {}
+
+TrpJsonWriter::TrpJsonWriter( int fd )
+    : TrpJsonOutput(fd), m_indent(0), m_fill(' '), m_colors(false), m_sort_keys(false),
+      m_after_key(false) {}
+
+void TrpJsonWriter::setIndent( size_t width, char fill ) {
+    m_indent = width;
+    m_fill = fill;
+}
+size_t TrpJsonWriter::getIndent( void ) const { return m_indent; }
+
+void TrpJsonWriter::setColors( TrpWriterColors mode ) {
+    m_colors = mode == WRITER_COLORS_ON;
+    if ( mode == WRITER_COLORS_AUTO && m_sink != WRITER_BUFFER )
+        m_colors = isatty( m_sink == WRITER_FILE ? (m_file ? fileno( m_file ) : -1) : m_fd ) == 1;
+}
+bool TrpJsonWriter::hasColors( void ) const { return m_colors; }
+void TrpJsonWriter::setSortKeys( bool enabled ) { m_sort_keys = enabled; }
+bool TrpJsonWriter::getSortKeys( void ) const { return m_sort_keys; }
+void TrpJsonWriter::clear( void ) {
+    m_size = 0;
+    m_stack.clear();
+    m_after_key = false;
+}
+
+void TrpJsonWriter::paint( const char* color ) {
+    if ( m_colors ) append( color, std::strlen( color ) );
+}
+
+void TrpJsonWriter::newline( size_t depth ) {
+    if ( !m_indent ) return;
+    size_t len = 1 + depth * m_indent;
+    if ( m_buffer.size() - m_size < len ) grow( len );
+    if ( m_buffer.size() - m_size < len ) {
+        put( '\n' );
+        for ( size_t i = 1; i < len; ++i )
+            put( m_fill );
+        return;
+    }
+    m_buffer[m_size] = '\n';
+    std::memset( &m_buffer[m_size + 1], m_fill, len - 1 );
+    m_size += len;
+}
+
+// runs without anything to escape are copied as they are, the scan is the lexer's. strings
+// are valid UTF-8 already, only " \ and control characters need work
+void TrpJsonWriter::writeString( const char* data, size_t len ) {
+    static const char hex[] = "0123456789abcdef";
+    const char* end = data + len;
+
+    put( '"' );
+    while ( data < end ) {
+        size_t run = TrpJsonSimd::findStringSpecial( data, end - data );
+        append( data, run );
+        data += run;
+        if ( data == end ) break;
+
+        unsigned char c = static_cast<unsigned char>(*data++);
+        if ( c >= 0x80 ) {
+            put( static_cast<char>(c) );
+            continue;
+        }
+        put( '\\' );
+        switch ( c ) {
+            case '"': put( '"' ); break;
+            case '\\': put( '\\' ); break;
+            case '\b': put( 'b' ); break;
+            case '\f': put( 'f' ); break;
+            case '\n': put( 'n' ); break;
+            case '\r': put( 'r' ); break;
+            case '\t': put( 't' ); break;
+            default: {
+                char u[5] = { 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                append( u, sizeof(u) );
+            }
+        }
+    }
+    put( '"' );
+}
+
+// raw numbers go out as they came in, integers exact, doubles as their shortest round-trip digits
+void TrpJsonWriter::writeNumber( const TrpJsonNumber* number ) {
+    if ( number->isRaw() ) {
+        std::string raw = number->getRaw();
+        append( raw.data(), raw.size() );
+        return;
+    }
+
+    // formatted right in the buffer, an emptied fixed one always has the room
+    if ( m_buffer.size() - m_size < TRP_NUMBER_FORMAT_BYTES ) grow( TRP_NUMBER_FORMAT_BYTES );
+    char* out = &m_buffer[m_size];
+    int64_t i;
+    uint64_t u;
+    size_t len;
+    if ( number->getInt64( i ) )
+        len = TrpJsonNumberFormat::formatInt64( i, out );
+    else if ( number->getUint64( u ) )
+        len = TrpJsonNumberFormat::formatUint64( u, out );
+    else
+        len = TrpJsonNumberFormat::formatDouble( number->getValue(), out );
+    m_size += len;
+}
+
+void TrpJsonWriter::writeScalar( ITrpJsonValue* value ) {
+    switch ( value ? value->getType() : TRP_NULL ) {
+        case TRP_STRING: {
+            TrpJsonString* str = static_cast<TrpJsonString*>(value);
+            paint( STRING_COLOR );
+            writeString( str->data(), str->size() );
+            break;
+        }
+        case TRP_NUMBER:
+            paint( NUMBER_COLOR );
+            writeNumber( static_cast<TrpJsonNumber*>(value) );
+            break;
+        case TRP_BOOL:
+            paint( BOOL_COLOR );
+            if ( static_cast<TrpJsonBool*>(value)->getValue() ) append( "true", 4 );
+            else append( "false", 5 );
+            break;
+        default:
+            paint( NULL_COLOR );
+            append( "null", 4 );
+            break;
+    }
+    paint( RESET );
+}
+
+void TrpJsonWriter::writeKey( const char* data, size_t len ) {
+    paint( KEY_COLOR );
+    writeString( data, len );
+    paint( RESET );
+    paint( PUNCT_COLOR );
+    put( ':' );
+    if ( m_indent ) put( ' ' );
+    paint( RESET );
+}
+
+void TrpJsonWriter::open( bool is_object ) {
+    paint( BRACE_COLOR );
+    put( is_object ? '{' : '[' );
+    paint( RESET );
+}
+
+// the innermost container is done, empty ones stay on their line: {} []
+void TrpJsonWriter::close( void ) {
+    Frame& frame = m_stack.back();
+    if ( frame.next ) newline( m_stack.size() - 1 );
+    paint( BRACE_COLOR );
+    put( frame.is_object ? '}' : ']' );
+    paint( RESET );
+    m_stack.pop_back();
+}
+
+// the comma and the line in front of the next member / element
+void TrpJsonWriter::separate( Frame& frame ) {
+    if ( frame.next ) {
+        paint( PUNCT_COLOR );
+        put( ',' );
+        paint( RESET );
+    }
+    newline( m_stack.size() );
+    ++frame.next;
+}
+
+static bool keyBefore( const JsonObjectEntry* a, const JsonObjectEntry* b ) {
+    size_t len = a->first.size() < b->first.size() ? a->first.size() : b->first.size();
+    int cmp = std::memcmp( a->first.data(), b->first.data(), len );
+    return cmp ? cmp < 0 : a->first.size() < b->first.size();
+}
+
+// the members go on top of m_order, the frames above this one are gone before it is
+void TrpJsonWriter::sortMembers( Frame& frame ) {
+    TrpJsonObject* object = static_cast<TrpJsonObject*>(frame.container);
+    frame.order = m_order.size();
+    frame.sorted = true;
+    for ( JsonObjectVector::const_iterator it = object->begin(); it != object->end(); ++it )
+        m_order.push_back( &*it );
+    std::stable_sort( m_order.begin() + frame.order, m_order.end(), keyBefore );
+}
+
+// our own stack like the parser: a container is opened, then each turn writes the next
+// member / element, closing every container that is done on the way up
+bool TrpJsonWriter::write( ITrpJsonValue* value ) {
+    m_stack.clear();
+    m_order.clear();
+    while ( true ) {
+        TrpJsonType type = value ? value->getType() : TRP_NULL;
+        if ( type == TRP_OBJECT || type == TRP_ARRAY ) {
+            Frame frame;
+            frame.container = value;
+            frame.next = 0;
+            frame.is_object = type == TRP_OBJECT;
+            frame.size = frame.is_object ? static_cast<TrpJsonObject*>(value)->size()
+                                         : static_cast<TrpJsonArray*>(value)->size();
+            frame.order = 0;
+            frame.sorted = false;
+            if ( frame.is_object && m_sort_keys && frame.size > 1 ) sortMembers( frame );
+            open( frame.is_object );
+            m_stack.push_back( frame );
+        } else {
+            writeScalar( value );
+        }
+
+        value = NULL;
+        bool more = false;
+        while ( !m_stack.empty() ) {
+            Frame& frame = m_stack.back();
+            if ( frame.next == frame.size ) {
+                if ( frame.sorted ) m_order.resize( frame.order );
+                close();
+                continue;
+            }
+            size_t index = frame.next;
+            separate( frame );
+            if ( frame.is_object ) {
+                TrpJsonObject* object = static_cast<TrpJsonObject*>(frame.container);
+                const JsonObjectEntry& entry = frame.sorted ? *m_order[frame.order + index]
+                                                            : *(object->begin() + index);
+                writeKey( entry.first.data(), entry.first.size() );
+                value = entry.second;
+            } else {
+                value = static_cast<TrpJsonArray*>(frame.container)->at( index );
+            }
+            more = true;
+            break;
+        }
+        if ( !more ) break;
+    }
+    return !m_failed;
+}
+
+// handler events. the stack only counts what each open container got so far
+
+// after a key the value goes right there, in an array it needs its comma and line first
+void TrpJsonWriter::beginValue( void ) {
+    if ( m_after_key )
+        m_after_key = false;
+    else if ( !m_stack.empty() )
+        separate( m_stack.back() );
+}
+
+bool TrpJsonWriter::onObjectStart( void ) {
+    beginValue();
+    open( true );
+    Frame frame = { NULL, 0, 0, 0, true, false };
+    m_stack.push_back( frame );
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onArrayStart( void ) {
+    beginValue();
+    open( false );
+    Frame frame = { NULL, 0, 0, 0, false, false };
+    m_stack.push_back( frame );
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onObjectEnd( size_t member_count ) {
+    (void)member_count;
+    close();
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onArrayEnd( size_t element_count ) {
+    (void)element_count;
+    close();
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onKey( const char* key, size_t len ) {
+    separate( m_stack.back() );
+    writeKey( key, len );
+    m_after_key = true;
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onString( const char* data, size_t len ) {
+    beginValue();
+    paint( STRING_COLOR );
+    writeString( data, len );
+    paint( RESET );
+    return !m_failed;
+}
+
+// the lexeme is valid JSON already, it goes out as it is
+bool TrpJsonWriter::onNumber( const char* lexeme, size_t len, const TrpNumber& number ) {
+    (void)number;
+    beginValue();
+    paint( NUMBER_COLOR );
+    append( lexeme, len );
+    paint( RESET );
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onBool( bool value ) {
+    beginValue();
+    paint( BOOL_COLOR );
+    if ( value ) append( "true", 4 );
+    else append( "false", 5 );
+    paint( RESET );
+    return !m_failed;
+}
+
+bool TrpJsonWriter::onNull( void ) {
+    beginValue();
+    paint( NULL_COLOR );
+    append( "null", 4 );
+    paint( RESET );
+    return !m_failed;
+}
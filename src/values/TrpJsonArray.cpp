@@ -1,12 +1,43 @@
 #include "../../include/values/TrpJsonArray.hpp"
 
-TrpJsonArray::TrpJsonArray( void ) {}
+TrpJsonArray::TrpJsonArray( TrpJsonArena* arena )
+    : m_elements(TrpJsonArenaAllocator<ITrpJsonValue*>(arena)), m_deferred(NULL) {}
 
 TrpJsonArray::~TrpJsonArray( void ) {
-    for (JsonArrayVector::iterator it = m_elements.begin();
-            it != m_elements.end(); it++) {
-        delete *it;
+    if (m_elements.get_allocator().arena)
+        return;
+    std::vector<ITrpJsonValue*> pending;
+    detachChildren(pending);
+    destroyAll(pending);
+}
+
+// backwards, destroyAll pops from the end and deleting in order is faster.
+// a deferred array has nothing to give, only its record to drop
+void TrpJsonArray::detachChildren( std::vector<ITrpJsonValue*>& out ) {
+    if (m_deferred && !m_elements.get_allocator().arena)
+        delete m_deferred;
+    m_deferred = NULL;
+    out.insert(out.end(), m_elements.rbegin(), m_elements.rend());
+    m_elements.clear();
+}
+
+// a broken subtree leaves the array empty, the parser has the error
+void TrpJsonArray::materialize( void ) const {
+    if (!m_deferred)
+        return;
+    TrpJsonDeferred* source = m_deferred;
+    m_deferred = NULL;
+
+    TrpJsonArray* self = const_cast<TrpJsonArray*>(this);
+    bool heap = !m_elements.get_allocator().arena;
+    if (!source->materializer->materialize(self, *source)) {
+        std::vector<ITrpJsonValue*> pending;
+        self->detachChildren(pending);
+        if (heap)
+            destroyAll(pending);
     }
+    if (heap)
+        delete source;
 }
 
 TrpJsonType TrpJsonArray::getType( void ) const {
@@ -14,13 +45,24 @@ TrpJsonType TrpJsonArray::getType( void ) const {
 }
 
 void TrpJsonArray::add(ITrpJsonValue *value) {
+    materialize();
     m_elements.push_back(value);
 }
 
 ITrpJsonValue* TrpJsonArray::at(size_t index) {
+    materialize();
     return m_elements.at(index);
 }
 
 size_t TrpJsonArray::size(void) const {
+    materialize();
     return m_elements.size();
-}
\ No newline at end of file
+}
+
+void TrpJsonArray::defer( TrpJsonDeferred* source ) {
+    m_deferred = source;
+}
+
+bool TrpJsonArray::isDeferred( void ) const {
+    return m_deferred != NULL;
+}
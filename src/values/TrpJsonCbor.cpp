@@ -0,0 +1,400 @@
+#include "../../include/values/TrpJsonCbor.hpp"
+#include "../../include/core/TrpJsonLexer.hpp"
+#include <cstring>
+#include <cmath>
+
+TrpJsonCbor::TrpJsonCbor( void ) : m_data(NULL), m_end(NULL), m_max_depth(TRP_CBOR_MAX_DEPTH) {}
+
+TrpJsonCbor::~TrpJsonCbor( void ) {}
+
+void TrpJsonCbor::setMaxDepth( size_t depth ) { m_max_depth = depth; }
+size_t TrpJsonCbor::getMaxDepth( void ) const { return m_max_depth; }
+const TrpJsonError& TrpJsonCbor::getError( void ) const { return m_error; }
+
+// binary input has no lines, only the offset means something
+bool TrpJsonCbor::fail( const unsigned char* at, TrpErrorCode code ) {
+    m_error.clear();
+    m_error.code = code;
+    m_error.offset = at - m_data;
+    return false;
+}
+
+const unsigned char* TrpJsonCbor::readHead( const unsigned char* p, const unsigned char* end, TrpCborHead& head ) {
+    if (p >= end)
+        return NULL;
+    head.major = *p >> 5;
+    head.info = *p & 0x1F;
+    head.indefinite = false;
+    head.argument = 0;
+    ++p;
+    if (head.info < TRP_CBOR_ARGUMENT_8) {
+        head.argument = head.info;
+    } else if (head.info <= TRP_CBOR_ARGUMENT_64) {
+        size_t bytes = static_cast<size_t>(1) << (head.info - TRP_CBOR_ARGUMENT_8);
+        if (static_cast<size_t>(end - p) < bytes)
+            return NULL;
+        for (size_t i = 0; i < bytes; ++i)
+            head.argument = (head.argument << 8) | p[i];
+        p += bytes;
+    } else if (head.info == TRP_CBOR_INDEFINITE) {
+        head.indefinite = true;
+    } else {
+        return NULL;
+    }
+    head.payload = p;
+    return p;
+}
+
+TrpErrorCode TrpJsonCbor::checkItem( const unsigned char*& p, const unsigned char* end, TrpCborHead& head ) {
+    if (p >= end)
+        return ERROR_CBOR_TRUNCATED;
+    unsigned info = *p & 0x1F;
+    if (info > TRP_CBOR_ARGUMENT_64 && info < TRP_CBOR_INDEFINITE)
+        return ERROR_CBOR_MALFORMED;
+    const unsigned char* next = readHead(p, end, head);
+    if (!next)
+        return ERROR_CBOR_TRUNCATED;
+
+    size_t left = end - next;
+    switch (head.major) {
+        case TRP_CBOR_UNSIGNED: case TRP_CBOR_NEGATIVE:
+            if (head.indefinite)
+                return ERROR_CBOR_MALFORMED;
+            break;
+        case TRP_CBOR_TEXT:
+            // chunked strings would have to be put together, no zero copy for them
+            if (head.indefinite)
+                return ERROR_CBOR_UNSUPPORTED;
+            if (head.argument > left)
+                return ERROR_CBOR_TRUNCATED;
+            if (!TrpJsonLexer::validUtf8(reinterpret_cast<const char*>(next), head.argument))
+                return ERROR_INVALID_UTF8;
+            next += head.argument;
+            break;
+        case TRP_CBOR_ARRAY: case TRP_CBOR_MAP:
+            // every item takes a byte at least, a bigger count can only be cut short
+            if (!head.indefinite && head.argument > (head.major == TRP_CBOR_MAP ? left / 2 : left))
+                return ERROR_CBOR_TRUNCATED;
+            break;
+        case TRP_CBOR_SIMPLE:
+            // a break where an item belongs
+            if (head.indefinite)
+                return ERROR_CBOR_MALFORMED;
+            switch (head.info) {
+                case TRP_CBOR_FALSE: case TRP_CBOR_TRUE: case TRP_CBOR_NULL:
+                    break;
+                // all ones in the exponent is infinity or NaN
+                case TRP_CBOR_HALF:
+                    if ((head.argument & 0x7C00) == 0x7C00)
+                        return ERROR_CBOR_UNSUPPORTED;
+                    break;
+                case TRP_CBOR_FLOAT:
+                    if ((head.argument & 0x7F800000) == 0x7F800000)
+                        return ERROR_CBOR_UNSUPPORTED;
+                    break;
+                case TRP_CBOR_DOUBLE:
+                    if ((head.argument & 0x7FF0000000000000ULL) == 0x7FF0000000000000ULL)
+                        return ERROR_CBOR_UNSUPPORTED;
+                    break;
+                default:
+                    return ERROR_CBOR_UNSUPPORTED;
+            }
+            break;
+        default:
+            return ERROR_CBOR_UNSUPPORTED;
+    }
+    p = next;
+    return ERROR_NONE;
+}
+
+double TrpJsonCbor::toDouble( const TrpCborHead& head ) {
+    if (head.major == TRP_CBOR_UNSIGNED)
+        return static_cast<double>(head.argument);
+    if (head.major == TRP_CBOR_NEGATIVE) {
+        // -1 - argument, which is -2^64 at the very end
+        if (head.argument == ~static_cast<uint64_t>(0))
+            return -18446744073709551616.0;
+        return -static_cast<double>(head.argument + 1);
+    }
+    switch (head.info) {
+        case TRP_CBOR_HALF: {
+            unsigned exponent = static_cast<unsigned>(head.argument >> 10) & 0x1F;
+            double mantissa = static_cast<double>(head.argument & 0x3FF);
+            double value = exponent ? std::ldexp(mantissa + 1024, exponent - 25) : std::ldexp(mantissa, -24);
+            return head.argument & 0x8000 ? -value : value;
+        }
+        case TRP_CBOR_FLOAT: {
+            uint32_t bits = static_cast<uint32_t>(head.argument);
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+        default: {
+            double d;
+            std::memcpy(&d, &head.argument, sizeof(d));
+            return d;
+        }
+    }
+}
+
+// counted arrays / maps only add their items to what is left, one count is enough for any
+// number of them. an open ended one needs to remember the count around it until its break
+const unsigned char* TrpJsonCbor::skip( const unsigned char* p, const unsigned char* end ) {
+    size_t pending = 1;
+    std::vector<size_t> outer;
+    TrpCborHead head;
+    while (true) {
+        if (!pending) {
+            if (outer.empty())
+                return p;
+            if (*p == TRP_CBOR_BREAK) {
+                ++p;
+                pending = outer.back();
+                outer.pop_back();
+                continue;
+            }
+            pending = 1;
+        }
+        --pending;
+        p = readHead(p, end, head);
+        switch (head.major) {
+            case TRP_CBOR_TEXT:
+                p += head.argument;
+                break;
+            case TRP_CBOR_ARRAY: case TRP_CBOR_MAP:
+                if (head.indefinite) {
+                    outer.push_back(pending);
+                    pending = 0;
+                } else {
+                    pending += head.major == TRP_CBOR_MAP ? head.argument * 2 : head.argument;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// the same walk as the parser's, only nothing gets built: a stack of open arrays / maps and
+// the items each one still has
+bool TrpJsonCbor::read( const char* data, size_t len ) {
+    m_data = reinterpret_cast<const unsigned char*>(data);
+    m_end = m_data + len;
+    m_error.clear();
+    m_levels.clear();
+
+    const unsigned char* p = m_data;
+    TrpCborHead head;
+    while (true) {
+        if (!m_levels.empty()) {
+            Level& level = m_levels.back();
+            // done: the count ran out or the break is here
+            if (!level.left || (level.left == TRP_CBOR_OPEN_ENDED && p < m_end && *p == TRP_CBOR_BREAK)) {
+                if (level.left)
+                    ++p;
+                m_levels.pop_back();
+                if (m_levels.empty())
+                    break;
+                continue;
+            }
+            if (level.left != TRP_CBOR_OPEN_ENDED)
+                --level.left;
+            if (level.is_map) {
+                const unsigned char* key = p;
+                TrpErrorCode code = checkItem(p, m_end, head);
+                if (code != ERROR_NONE)
+                    return fail(key, code);
+                if (head.major != TRP_CBOR_TEXT)
+                    return fail(key, ERROR_CBOR_KEY_NOT_STRING);
+            }
+        }
+
+        const unsigned char* at = p;
+        TrpErrorCode code = checkItem(p, m_end, head);
+        if (code != ERROR_NONE)
+            return fail(at, code);
+        if (head.major == TRP_CBOR_ARRAY || head.major == TRP_CBOR_MAP) {
+            if (m_max_depth && m_levels.size() >= m_max_depth)
+                return fail(at, ERROR_MAX_DEPTH);
+            Level level;
+            level.left = head.indefinite ? TRP_CBOR_OPEN_ENDED : static_cast<size_t>(head.argument);
+            level.is_map = head.major == TRP_CBOR_MAP;
+            m_levels.push_back(level);
+        } else if (m_levels.empty()) {
+            break;
+        }
+    }
+    if (p != m_end)
+        return fail(p, ERROR_CBOR_TRAILING_DATA);
+    return true;
+}
+
+TrpJsonCborRef TrpJsonCbor::root( void ) const {
+    if (!m_data || m_error.code != ERROR_NONE)
+        return TrpJsonCborRef();
+    return TrpJsonCborRef(m_data, m_end, 1);
+}
+
+// TrpJsonCborRef
+
+TrpJsonCborRef::TrpJsonCborRef( void ) : m_item(NULL), m_end(NULL), m_left(0) {}
+
+TrpJsonCborRef::TrpJsonCborRef( const unsigned char* item, const unsigned char* end, size_t left )
+    : m_item(item), m_end(end), m_left(left) {}
+
+TrpCborHead TrpJsonCborRef::head( void ) const {
+    TrpCborHead h;
+    TrpJsonCbor::readHead(m_item, m_end, h);
+    return h;
+}
+
+bool TrpJsonCborRef::isValid( void ) const {
+    return m_item != NULL;
+}
+
+TrpJsonType TrpJsonCborRef::getType( void ) const {
+    if (!isValid())
+        return TRP_ERROR;
+    TrpCborHead h = head();
+    switch (h.major) {
+        case TRP_CBOR_UNSIGNED: case TRP_CBOR_NEGATIVE: return TRP_NUMBER;
+        case TRP_CBOR_TEXT: return TRP_STRING;
+        case TRP_CBOR_ARRAY: return TRP_ARRAY;
+        case TRP_CBOR_MAP: return TRP_OBJECT;
+        default: break;
+    }
+    switch (h.info) {
+        case TRP_CBOR_FALSE: case TRP_CBOR_TRUE: return TRP_BOOL;
+        case TRP_CBOR_NULL: return TRP_NULL;
+        default: return TRP_NUMBER;
+    }
+}
+
+bool TrpJsonCborRef::getBool( void ) const {
+    return isValid() && *m_item == ((TRP_CBOR_SIMPLE << 5) | TRP_CBOR_TRUE);
+}
+
+double TrpJsonCborRef::getDouble( void ) const {
+    if (getType() != TRP_NUMBER)
+        return 0;
+    return TrpJsonCbor::toDouble(head());
+}
+
+// like TrpJsonNumber: the magnitude fits in 64 bits, only -2^64 does not
+bool TrpJsonCborRef::isInteger( void ) const {
+    if (!isValid())
+        return false;
+    TrpCborHead h = head();
+    return h.major == TRP_CBOR_UNSIGNED || (h.major == TRP_CBOR_NEGATIVE && h.argument != ~static_cast<uint64_t>(0));
+}
+
+bool TrpJsonCborRef::getInt64( int64_t& out ) const {
+    if (!isValid())
+        return false;
+    TrpCborHead h = head();
+    if ((h.major != TRP_CBOR_UNSIGNED && h.major != TRP_CBOR_NEGATIVE) || h.argument >= (static_cast<uint64_t>(1) << 63))
+        return false;
+    out = h.major == TRP_CBOR_UNSIGNED ? static_cast<int64_t>(h.argument) : -1 - static_cast<int64_t>(h.argument);
+    return true;
+}
+
+bool TrpJsonCborRef::getUint64( uint64_t& out ) const {
+    if (!isValid())
+        return false;
+    TrpCborHead h = head();
+    if (h.major != TRP_CBOR_UNSIGNED)
+        return false;
+    out = h.argument;
+    return true;
+}
+
+const char* TrpJsonCborRef::getString( void ) const {
+    if (!isValid())
+        return NULL;
+    TrpCborHead h = head();
+    if (h.major != TRP_CBOR_TEXT)
+        return NULL;
+    return reinterpret_cast<const char*>(h.payload);
+}
+
+size_t TrpJsonCborRef::getStringLength( void ) const {
+    if (!isValid())
+        return 0;
+    TrpCborHead h = head();
+    return h.major == TRP_CBOR_TEXT ? static_cast<size_t>(h.argument) : 0;
+}
+
+std::string TrpJsonCborRef::getValue( void ) const {
+    const char* s = getString();
+    if (!s)
+        return std::string();
+    return std::string(s, getStringLength());
+}
+
+size_t TrpJsonCborRef::size( void ) const {
+    TrpJsonType type = getType();
+    if (type != TRP_ARRAY && type != TRP_OBJECT)
+        return 0;
+    TrpCborHead h = head();
+    if (!h.indefinite)
+        return static_cast<size_t>(h.argument);
+    size_t count = 0;
+    for (TrpJsonCborRef child = first(); child.isValid(); child = child.next())
+        ++count;
+    return type == TRP_OBJECT ? count / 2 : count;
+}
+
+TrpJsonCborRef TrpJsonCborRef::first( void ) const {
+    TrpJsonType type = getType();
+    if (type != TRP_ARRAY && type != TRP_OBJECT)
+        return TrpJsonCborRef();
+    TrpCborHead h = head();
+    if (h.indefinite) {
+        if (*h.payload == TRP_CBOR_BREAK)
+            return TrpJsonCborRef();
+        return TrpJsonCborRef(h.payload, m_end, TRP_CBOR_OPEN_ENDED);
+    }
+    size_t items = static_cast<size_t>(type == TRP_OBJECT ? h.argument * 2 : h.argument);
+    if (!items)
+        return TrpJsonCborRef();
+    return TrpJsonCborRef(h.payload, m_end, items);
+}
+
+TrpJsonCborRef TrpJsonCborRef::next( void ) const {
+    if (!isValid())
+        return TrpJsonCborRef();
+    const unsigned char* p = TrpJsonCbor::skip(m_item, m_end);
+    if (m_left == TRP_CBOR_OPEN_ENDED) {
+        if (*p == TRP_CBOR_BREAK)
+            return TrpJsonCborRef();
+        return TrpJsonCborRef(p, m_end, TRP_CBOR_OPEN_ENDED);
+    }
+    if (m_left <= 1)
+        return TrpJsonCborRef();
+    return TrpJsonCborRef(p, m_end, m_left - 1);
+}
+
+TrpJsonCborRef TrpJsonCborRef::at( size_t index ) const {
+    if (getType() != TRP_ARRAY)
+        return TrpJsonCborRef();
+    TrpJsonCborRef child = first();
+    for (; index > 0 && child.isValid(); --index)
+        child = child.next();
+    return child;
+}
+
+// linear, keys are compared straight in the input
+TrpJsonCborRef TrpJsonCborRef::find( const std::string& key ) const {
+    if (getType() != TRP_OBJECT)
+        return TrpJsonCborRef();
+    for (TrpJsonCborRef k = first(); k.isValid(); k = k.next().next()) {
+        if (k.getStringLength() == key.size()
+                && std::memcmp(k.getString(), key.data(), key.size()) == 0)
+            return k.next();
+    }
+    return TrpJsonCborRef();
+}
+
+const char* TrpJsonCborRef::position( void ) const {
+    return reinterpret_cast<const char*>(m_item);
+}
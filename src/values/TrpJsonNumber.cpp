@@ -1,11 +1,73 @@
 #include "../../include/values/TrpJsonNumber.hpp"
 
-TrpJsonNumber::~TrpJsonNumber( void ) {}
+TrpJsonNumber::TrpJsonNumber( double value ) : m_converted(true) {
+    m_number.value = value;
+    m_number.negative = value < 0;
+    m_number.is_integer = false;
+    m_number.magnitude = 0;
+}
+
+TrpJsonNumber::TrpJsonNumber( const TrpNumber& number ) : m_number(number), m_converted(true) {}
+
+TrpJsonNumber::TrpJsonNumber( const char* lexeme, size_t len, TrpJsonArena* arena )
+    : m_converted(false), m_raw(lexeme, len, arena) {}
+
+TrpJsonNumber::~TrpJsonNumber( void ) {
+    m_raw.release();
+}
+
+void TrpJsonNumber::convert( void ) const {
+    size_t length;
+    TrpJsonNumberParser::parse(m_raw.data(), m_raw.data() + m_raw.size(), m_number, length);
+    m_converted = true;
+}
 
 TrpJsonType TrpJsonNumber::getType( void ) const {
     return TRP_NUMBER;
 }
 
 const double& TrpJsonNumber::getValue( void ) const {
-    return m_value;
-}
\ No newline at end of file
+    if (!m_converted)
+        convert();
+    return m_number.value;
+}
+
+bool TrpJsonNumber::isInteger( void ) const {
+    if (!m_converted)
+        convert();
+    return m_number.is_integer;
+}
+
+// the magnitude of a negative number can go one past INT64_MAX
+bool TrpJsonNumber::getInt64( int64_t& out ) const {
+    if (!isInteger())
+        return false;
+    const uint64_t limit = static_cast<uint64_t>(1) << 63;
+    if (m_number.negative) {
+        if (m_number.magnitude > limit)
+            return false;
+        out = static_cast<int64_t>(0 - m_number.magnitude);
+    } else {
+        if (m_number.magnitude >= limit)
+            return false;
+        out = static_cast<int64_t>(m_number.magnitude);
+    }
+    return true;
+}
+
+bool TrpJsonNumber::getUint64( uint64_t& out ) const {
+    if (!isInteger())
+        return false;
+    if (m_number.negative && m_number.magnitude != 0)
+        return false;
+    out = m_number.magnitude;
+    return true;
+}
+
+bool TrpJsonNumber::isRaw( void ) const {
+    return !m_raw.empty();
+}
+
+std::string TrpJsonNumber::getRaw( void ) const {
+    return m_raw.str();
+}
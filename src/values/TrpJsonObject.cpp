@@ -1,46 +1,159 @@
 #include "../../include/values/TrpJsonObject.hpp"
 
-TrpJsonObject::TrpJsonObject( void ) {}
+TrpJsonObject::TrpJsonObject( TrpJsonArena* arena )
+    : m_members(TrpJsonArenaAllocator<JsonObjectEntry>(arena)),
+      m_index(TrpJsonArenaAllocator<uint32_t>(arena)), m_deferred(NULL) {}
 
 TrpJsonObject::~TrpJsonObject( void ) {
-    for (JsonObjectMap::iterator it = m_members.begin();
-            it != m_members.end(); it++) {
-        delete it->second;
-        it->second = NULL;
+    if (m_members.get_allocator().arena)
+        return;
+    std::vector<ITrpJsonValue*> pending;
+    detachChildren(pending);
+    destroyAll(pending);
+}
+
+// backwards so they get deleted in order, malloc likes that a lot better
+void TrpJsonObject::detachChildren( std::vector<ITrpJsonValue*>& out ) {
+    if (m_deferred && !m_members.get_allocator().arena)
+        delete m_deferred;
+    m_deferred = NULL;
+    for (JsonObjectVector::reverse_iterator it = m_members.rbegin();
+            it != m_members.rend(); it++) {
+        it->first.release();
+        out.push_back(it->second);
+    }
+    m_members.clear();
+    m_index.clear();
+}
+
+// same as the array: a broken subtree leaves the object empty
+void TrpJsonObject::materialize( void ) const {
+    if (!m_deferred)
+        return;
+    TrpJsonDeferred* source = m_deferred;
+    m_deferred = NULL;
+
+    TrpJsonObject* self = const_cast<TrpJsonObject*>(this);
+    bool heap = !m_members.get_allocator().arena;
+    if (!source->materializer->materialize(self, *source)) {
+        std::vector<ITrpJsonValue*> pending;
+        self->detachChildren(pending);
+        if (heap)
+            destroyAll(pending);
     }
+    if (heap)
+        delete source;
 }
 
 TrpJsonType TrpJsonObject::getType( void ) const {
     return (TRP_OBJECT);
 }
 
-void TrpJsonObject::add(std::string key,ITrpJsonValue* value) {
-    JsonObjectMap::iterator it = m_members.find(key);
-    if (it != m_members.end()) {
-        delete it->second;
-        it->second = value;
+// FNV-1a, keys are short
+uint32_t TrpJsonObject::hashKey( const char* key, size_t len ) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t TrpJsonObject::findPosition( const char* key, size_t len ) const {
+    if (m_index.empty()) {
+        for (size_t i = 0; i < m_members.size(); ++i) {
+            if (m_members[i].first.equals(key, len))
+                return i;
+        }
+        return m_members.size();
+    }
+
+    size_t mask = m_index.size() - 1;
+    for (size_t slot = hashKey(key, len) & mask; m_index[slot]; slot = (slot + 1) & mask) {
+        if (m_members[m_index[slot] - 1].first.equals(key, len))
+            return m_index[slot] - 1;
+    }
+    return m_members.size();
+}
+
+void TrpJsonObject::indexMember( size_t position ) {
+    const TrpJsonText& key = m_members[position].first;
+    size_t mask = m_index.size() - 1;
+    size_t slot = hashKey(key.data(), key.size()) & mask;
+    while (m_index[slot])
+        slot = (slot + 1) & mask;
+    m_index[slot] = static_cast<uint32_t>(position + 1);
+}
+
+// keeps the load under one half
+void TrpJsonObject::rebuildIndex( void ) {
+    size_t capacity = 64;
+    while (capacity < m_members.size() * 2)
+        capacity *= 2;
+    m_index.assign(capacity, 0);
+    for (size_t i = 0; i < m_members.size(); ++i)
+        indexMember(i);
+}
+
+void TrpJsonObject::add(const std::string& key, ITrpJsonValue* value) {
+    add(TrpJsonText(key.data(), key.size(), m_members.get_allocator().arena), value);
+}
+
+void TrpJsonObject::add(const TrpJsonText& key, ITrpJsonValue* value) {
+    materialize();
+    size_t position = findPosition(key.data(), key.size());
+    if (position != m_members.size()) {
+        if (!m_members.get_allocator().arena) {
+            TrpJsonText(key).release();
+            delete m_members[position].second;
+        }
+        m_members[position].second = value;
+        return;
+    }
+
+    m_members.push_back(JsonObjectEntry(key, value));
+
+    if (m_members.size() * 2 > m_index.size()) {
+        if (m_members.size() > TRP_OBJECT_HASH_THRESHOLD)
+            rebuildIndex();
     } else {
-        m_members.insert(JsonObjectEntry(key, value));
+        indexMember(m_members.size() - 1);
     }
 }
 
 ITrpJsonValue* TrpJsonObject::find(std::string key) {
-    JsonObjectMap::iterator it = m_members.find(key);
-    if (it != m_members.end()) {
-        return it->second;
+    return find(key.data(), key.size());
+}
+
+ITrpJsonValue* TrpJsonObject::find(const char* key, size_t len) {
+    materialize();
+    size_t position = findPosition(key, len);
+    if (position != m_members.size()) {
+        return m_members[position].second;
     }
     return NULL;
 }
 
 // Iterator support for serialization
-JsonObjectMap::const_iterator TrpJsonObject::begin() const {
+JsonObjectVector::const_iterator TrpJsonObject::begin() const {
+    materialize();
     return m_members.begin();
 }
 
-JsonObjectMap::const_iterator TrpJsonObject::end() const {
+JsonObjectVector::const_iterator TrpJsonObject::end() const {
+    materialize();
     return m_members.end();
 }
 
 size_t TrpJsonObject::size() const {
+    materialize();
     return m_members.size();
 }
+
+void TrpJsonObject::defer( TrpJsonDeferred* source ) {
+    m_deferred = source;
+}
+
+bool TrpJsonObject::isDeferred( void ) const {
+    return m_deferred != NULL;
+}
@@ -1,11 +1,21 @@
 #include "../../include/values/TrpJsonString.hpp"
 
-TrpJsonString::~TrpJsonString( void ) {}
+TrpJsonString::~TrpJsonString( void ) {
+    m_value.release();
+}
 
 TrpJsonType TrpJsonString::getType( void ) const {
     return TRP_STRING;
 }
 
-const std::string& TrpJsonString::getValue( void ) const {
-    return m_value;
-}
\ No newline at end of file
+std::string TrpJsonString::getValue( void ) const {
+    return m_value.str();
+}
+
+const char* TrpJsonString::data( void ) const {
+    return m_value.data();
+}
+
+size_t TrpJsonString::size( void ) const {
+    return m_value.size();
+}
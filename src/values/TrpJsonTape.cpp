@@ -0,0 +1,221 @@
+#include "../../include/values/TrpJsonTape.hpp"
+#include <cstring>
+
+TrpJsonTape::TrpJsonTape( void ) {}
+
+TrpJsonTape::~TrpJsonTape( void ) {}
+
+char TrpJsonTape::tagOf( uint64_t word ) {
+    return static_cast<char>(word >> TRP_TAPE_TAG_SHIFT);
+}
+
+uint64_t TrpJsonTape::word( size_t index ) const {
+    return m_tape[index];
+}
+
+size_t TrpJsonTape::append( char tag, uint64_t payload ) {
+    m_tape.push_back((static_cast<uint64_t>(static_cast<unsigned char>(tag)) << TRP_TAPE_TAG_SHIFT)
+        | (payload & TRP_TAPE_PAYLOAD_MASK));
+    return m_tape.size() - 1;
+}
+
+void TrpJsonTape::appendNumber( char tag, uint64_t bits ) {
+    append(tag, 0);
+    m_tape.push_back(bits);
+}
+
+void TrpJsonTape::appendString( const char* data, size_t len ) {
+    append('"', m_strings.size());
+    uint32_t length = static_cast<uint32_t>(len);
+    const char* length_bytes = reinterpret_cast<const char*>(&length);
+    m_strings.insert(m_strings.end(), length_bytes, length_bytes + sizeof(length));
+    m_strings.insert(m_strings.end(), data, data + len);
+    m_strings.push_back('\0');
+}
+
+// the open word learns where its subtree ends, that is what makes skipping O(1)
+void TrpJsonTape::closeContainer( size_t open, char close_tag, size_t count ) {
+    size_t close = append(close_tag, open);
+    if (count > TRP_TAPE_COUNT_MAX)
+        count = TRP_TAPE_COUNT_MAX;
+    char open_tag = tagOf(m_tape[open]);
+    m_tape[open] = (static_cast<uint64_t>(static_cast<unsigned char>(open_tag)) << TRP_TAPE_TAG_SHIFT)
+        | (static_cast<uint64_t>(count) << 32) | static_cast<uint64_t>(close + 1);
+}
+
+TrpJsonTapeRef TrpJsonTape::root( void ) const {
+    if (m_tape.empty())
+        return TrpJsonTapeRef();
+    return TrpJsonTapeRef(this, 0);
+}
+
+bool TrpJsonTape::empty( void ) const {
+    return m_tape.empty();
+}
+
+void TrpJsonTape::clear( void ) {
+    m_tape.clear();
+    m_strings.clear();
+}
+
+size_t TrpJsonTape::tapeSize( void ) const {
+    return m_tape.size();
+}
+
+size_t TrpJsonTape::stringBytes( void ) const {
+    return m_strings.size();
+}
+
+// TrpJsonTapeRef
+
+TrpJsonTapeRef::TrpJsonTapeRef( void ) : m_tape(NULL), m_index(0) {}
+
+TrpJsonTapeRef::TrpJsonTapeRef( const TrpJsonTape* tape, size_t index ) : m_tape(tape), m_index(index) {}
+
+bool TrpJsonTapeRef::isValid( void ) const {
+    if (!m_tape || m_index >= m_tape->m_tape.size())
+        return false;
+    char tag = TrpJsonTape::tagOf(m_tape->m_tape[m_index]);
+    return tag != '}' && tag != ']';
+}
+
+TrpJsonType TrpJsonTapeRef::getType( void ) const {
+    if (!isValid())
+        return TRP_ERROR;
+    switch (TrpJsonTape::tagOf(m_tape->m_tape[m_index])) {
+        case '{': return TRP_OBJECT;
+        case '[': return TRP_ARRAY;
+        case '"': return TRP_STRING;
+        case 'l': case 'u': case 'd': return TRP_NUMBER;
+        case 't': case 'f': return TRP_BOOL;
+        case 'n': return TRP_NULL;
+        default: return TRP_ERROR;
+    }
+}
+
+bool TrpJsonTapeRef::getBool( void ) const {
+    return isValid() && TrpJsonTape::tagOf(m_tape->m_tape[m_index]) == 't';
+}
+
+double TrpJsonTapeRef::getDouble( void ) const {
+    if (getType() != TRP_NUMBER)
+        return 0;
+    uint64_t bits = m_tape->m_tape[m_index + 1];
+    switch (TrpJsonTape::tagOf(m_tape->m_tape[m_index])) {
+        case 'l': return static_cast<double>(static_cast<int64_t>(bits));
+        case 'u': return static_cast<double>(bits);
+        default: {
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            return d;
+        }
+    }
+}
+
+bool TrpJsonTapeRef::isInteger( void ) const {
+    if (!isValid())
+        return false;
+    char tag = TrpJsonTape::tagOf(m_tape->m_tape[m_index]);
+    return tag == 'l' || tag == 'u';
+}
+
+// 'l' is only used for negative numbers, 'u' for everything >= 0
+bool TrpJsonTapeRef::getInt64( int64_t& out ) const {
+    if (!isInteger())
+        return false;
+    uint64_t bits = m_tape->m_tape[m_index + 1];
+    if (TrpJsonTape::tagOf(m_tape->m_tape[m_index]) == 'u' && bits >= (static_cast<uint64_t>(1) << 63))
+        return false;
+    out = static_cast<int64_t>(bits);
+    return true;
+}
+
+bool TrpJsonTapeRef::getUint64( uint64_t& out ) const {
+    if (!isInteger() || TrpJsonTape::tagOf(m_tape->m_tape[m_index]) != 'u')
+        return false;
+    out = m_tape->m_tape[m_index + 1];
+    return true;
+}
+
+const char* TrpJsonTapeRef::getString( void ) const {
+    if (getType() != TRP_STRING)
+        return NULL;
+    size_t offset = static_cast<size_t>(m_tape->m_tape[m_index] & TRP_TAPE_PAYLOAD_MASK);
+    return &m_tape->m_strings[offset + sizeof(uint32_t)];
+}
+
+size_t TrpJsonTapeRef::getStringLength( void ) const {
+    if (getType() != TRP_STRING)
+        return 0;
+    size_t offset = static_cast<size_t>(m_tape->m_tape[m_index] & TRP_TAPE_PAYLOAD_MASK);
+    uint32_t length;
+    std::memcpy(&length, &m_tape->m_strings[offset], sizeof(length));
+    return length;
+}
+
+std::string TrpJsonTapeRef::getValue( void ) const {
+    const char* s = getString();
+    if (!s)
+        return std::string();
+    return std::string(s, getStringLength());
+}
+
+// the count saturates, past that we walk
+size_t TrpJsonTapeRef::size( void ) const {
+    TrpJsonType type = getType();
+    if (type != TRP_ARRAY && type != TRP_OBJECT)
+        return 0;
+    size_t count = static_cast<size_t>((m_tape->m_tape[m_index] >> 32) & TRP_TAPE_COUNT_MAX);
+    if (count < TRP_TAPE_COUNT_MAX)
+        return count;
+    count = 0;
+    for (TrpJsonTapeRef child = first(); child.isValid(); child = child.next())
+        ++count;
+    return type == TRP_OBJECT ? count / 2 : count;
+}
+
+TrpJsonTapeRef TrpJsonTapeRef::first( void ) const {
+    TrpJsonType type = getType();
+    if (type != TRP_ARRAY && type != TRP_OBJECT)
+        return TrpJsonTapeRef();
+    return TrpJsonTapeRef(m_tape, m_index + 1);
+}
+
+TrpJsonTapeRef TrpJsonTapeRef::next( void ) const {
+    if (!isValid())
+        return TrpJsonTapeRef();
+    uint64_t word = m_tape->m_tape[m_index];
+    switch (TrpJsonTape::tagOf(word)) {
+        case '{': case '[':
+            return TrpJsonTapeRef(m_tape, static_cast<size_t>(word & TRP_TAPE_INDEX_MASK));
+        case 'l': case 'u': case 'd':
+            return TrpJsonTapeRef(m_tape, m_index + 2);
+        default:
+            return TrpJsonTapeRef(m_tape, m_index + 1);
+    }
+}
+
+TrpJsonTapeRef TrpJsonTapeRef::at( size_t index ) const {
+    if (getType() != TRP_ARRAY)
+        return TrpJsonTapeRef();
+    TrpJsonTapeRef child = first();
+    for (; index > 0 && child.isValid(); --index)
+        child = child.next();
+    return child;
+}
+
+// linear, keys are compared straight in the string buffer
+TrpJsonTapeRef TrpJsonTapeRef::find( const std::string& key ) const {
+    if (getType() != TRP_OBJECT)
+        return TrpJsonTapeRef();
+    for (TrpJsonTapeRef k = first(); k.isValid(); k = k.next().next()) {
+        if (k.getStringLength() == key.size()
+                && std::memcmp(k.getString(), key.data(), key.size()) == 0)
+            return k.next();
+    }
+    return TrpJsonTapeRef();
+}
+
+size_t TrpJsonTapeRef::getIndex( void ) const {
+    return m_index;
+}
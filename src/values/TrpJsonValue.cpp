@@ -1,3 +1,15 @@
 #include "../../include/core/TrpJsonValue.hpp"
 
-ITrpJsonValue::~ITrpJsonValue( void ) {}
\ No newline at end of file
+ITrpJsonValue::~ITrpJsonValue( void ) {}
+
+void ITrpJsonValue::detachChildren( std::vector<ITrpJsonValue*>& ) {}
+
+// children are detached before the delete, so every destructor only sees an empty container
+void ITrpJsonValue::destroyAll( std::vector<ITrpJsonValue*>& pending ) {
+    while (!pending.empty()) {
+        ITrpJsonValue* value = pending.back();
+        pending.pop_back();
+        value->detachChildren(pending);
+        delete value;
+    }
+}
\ No newline at end of file